@@ -0,0 +1,128 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "binarypack.h"
+#include "levelpack.h"
+#include "levels.h"
+#include "solver.h"
+#include "threadpool.h"
+
+// Solves every level of a pack in parallel, one level per task, and writes a CSV line per level:
+//   sokoban-batch [--threads N] [--ida | --bidirectional] [--max-nodes N] [--time-limit SECONDS]
+//                 [--memory-mb MB] [--table-mb MB] [--csv FILE] [PACK]
+// Without PACK the built-in levels are solved. The limits apply to each level on its own.
+// The CSV goes to standard output unless --csv is given.
+namespace {
+
+const char* limitName(SolverLimit limit) {
+    switch (limit) {
+    case LIMIT_NODES:
+        return "node limit";
+    case LIMIT_TIME:
+        return "time limit";
+    case LIMIT_MEMORY:
+        return "memory limit";
+    case LIMIT_UNSUPPORTED:
+        return "unsupported";
+    default:
+        return "no solution";
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    SolverOptions options;
+    options.timeLimit = 10.0;
+    options.tableBytes = size_t(16) << 20;
+    options.memoryLimit = size_t(256) << 20;
+    int threadCount = 0;
+    std::string packPath;
+    std::string csvPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threadCount = std::atoi(argv[++i]);
+        } else if (std::strcmp(argv[i], "--ida") == 0) {
+            options.algorithm = SOLVER_IDASTAR;
+        } else if (std::strcmp(argv[i], "--bidirectional") == 0) {
+            options.algorithm = SOLVER_BIDIRECTIONAL;
+        } else if (std::strcmp(argv[i], "--max-nodes") == 0 && i + 1 < argc) {
+            options.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc) {
+            options.timeLimit = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--memory-mb") == 0 && i + 1 < argc) {
+            options.memoryLimit = size_t(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        } else if (std::strcmp(argv[i], "--table-mb") == 0 && i + 1 < argc) {
+            options.tableBytes = size_t(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        } else if (std::strcmp(argv[i], "--csv") == 0 && i + 1 < argc) {
+            csvPath = argv[++i];
+        } else if (argv[i][0] == '-' || !packPath.empty()) {
+            std::cerr << "Usage: " << argv[0] << " [--threads N] [--ida | --bidirectional] [--max-nodes N]"
+                      << " [--time-limit SECONDS] [--memory-mb MB] [--table-mb MB] [--csv FILE] [PACK]" << std::endl;
+            return 1;
+        } else {
+            packPath = argv[i];
+        }
+    }
+
+    std::vector<Board> levels;
+    if (packPath.empty()) {
+        levels = loadBuiltinLevels();
+    } else if (BinaryLevelPack::isBinaryPackPath(packPath)) {
+        if (!loadBinaryPack(packPath, levels)) {
+            return 1;
+        }
+    } else if (!loadLevelPack(packPath, levels)) {
+        return 1;
+    }
+
+    // Every task writes only its own slot, so the results need no locking.
+    std::vector<SolverResult> results(levels.size());
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    int threadsUsed = 0;
+    uint64_t steals = 0;
+    {
+        WorkStealingPool pool(threadCount);
+        for (size_t i = 0; i < levels.size(); i++) {
+            pool.submit([&levels, &results, &options, i]() { results[i] = solveLevel(levels[i], options); });
+        }
+        pool.wait();
+        threadsUsed = pool.threadCount();
+        steals = pool.steals();
+    }
+    double wallMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+
+    std::ofstream file;
+    if (!csvPath.empty()) {
+        file.open(csvPath, std::ios::trunc);
+        if (!file) {
+            std::cerr << "Unable to write " << csvPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& csv = csvPath.empty() ? std::cout : file;
+    csv << "level,solved,moves,pushes,nodes,ms,stopped\n";
+    int solvedCount = 0;
+    double solverMs = 0.0;
+    for (size_t i = 0; i < results.size(); i++) {
+        const SolverResult& result = results[i];
+        char ms[32];
+        std::snprintf(ms, sizeof(ms), "%.3f", result.stats.milliseconds);
+        csv << i + 1 << ',' << (result.solved ? 1 : 0) << ',' << result.moves.size() << ',' << result.pushes << ','
+            << result.stats.expanded << ',' << ms << ',' << (result.solved ? "" : limitName(result.stats.limit)) << '\n';
+        solvedCount += result.solved;
+        solverMs += result.stats.milliseconds;
+    }
+    csv.flush();
+
+    // The summary goes to stderr so the CSV on stdout stays clean.
+    std::cerr << solvedCount << "/" << results.size() << " solved on " << threadsUsed << " threads in " << wallMs
+              << " ms (" << solverMs << " ms of solver time, " << (wallMs > 0.0 ? solverMs / wallMs : 0.0)
+              << "x parallel, " << steals << " steals)" << std::endl;
+    return solvedCount == int(results.size()) ? 0 : 2;
+}
@@ -0,0 +1,390 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <algorithm>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "binarypack.h"
+#include "deadlock.h"
+#include "levelpack.h"
+#include "levels.h"
+#include "pushdistance.h"
+#include "solver.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Runs `body` until at least `minSeconds` have passed and returns the mean time per call in ns.
+template <typename Body>
+double measure(Body body, double minSeconds = 0.2) {
+    uint64_t iterations = 0;
+    Clock::time_point started = Clock::now();
+    double elapsed = 0.0;
+    do {
+        for (int i = 0; i < 64; i++) {
+            body();
+        }
+        iterations += 64;
+        elapsed = std::chrono::duration<double>(Clock::now() - started).count();
+    } while (elapsed < minSeconds);
+    return elapsed * 1e9 / iterations;
+}
+
+// The fastest of `runs` shorter measure() calls, for timings that a busy machine would blur.
+template <typename Body>
+double measureBest(Body body, int runs = 5) {
+    double best = measure(body, 0.05);
+    for (int i = 1; i < runs; i++) {
+        best = std::min(best, measure(body, 0.05));
+    }
+    return best;
+}
+
+void benchDeadSquares(const std::vector<Board>& levels) {
+    std::cout << "Dead square precomputation" << std::endl;
+    for (size_t i = 0; i < levels.size(); i++) {
+        Board board = levels[i];
+        double ns = measure([&board]() { markDeadSquares(board); });
+        int dead = 0;
+        int interior = countInteriorCells(board, &dead);
+        std::cout << "  level " << i + 1 << ": " << std::fixed << std::setprecision(2) << ns / 1000.0 << " us, "
+                  << dead << "/" << interior << " interior cells dead ("
+                  << std::setprecision(1) << (interior ? 100.0 * dead / interior : 0.0) << "%)" << std::endl;
+    }
+}
+
+// Times isFreezeDeadlock() on positions reached by random play: every push of a random walk
+// is recorded, and the walk restarts from the initial position once it deadlocks.
+void benchFreezeDeadlocks(const std::vector<Board>& levels) {
+    std::cout << "Freeze deadlock check after a push" << std::endl;
+    for (size_t i = 0; i < levels.size(); i++) {
+        std::vector<Board> samples;
+        std::vector<Point> pushedBoxes;
+        Board board = levels[i];
+        uint32_t seed = 12345;
+        int deadlocked = 0;
+        while (samples.size() < 2000) {
+            seed = seed * 1103515245 + 12345;
+            int dir = (seed >> 16) % DIRECTION_COUNT;
+            bool pushed = false;
+            if (!board.movePlayer(DIR_DX[dir], DIR_DY[dir], &pushed) || !pushed) {
+                continue;
+            }
+            Point box = { board.player().x + DIR_DX[dir], board.player().y + DIR_DY[dir] };
+            samples.push_back(board);
+            pushedBoxes.push_back(box);
+            if (board.isDead(box.x, box.y) || isFreezeDeadlock(board, box.x, box.y)) {
+                deadlocked++;
+                board.resetFrom(levels[i]);
+            }
+        }
+
+        size_t next = 0;
+        double ns = measure([&]() {
+            isFreezeDeadlock(samples[next], pushedBoxes[next].x, pushedBoxes[next].y);
+            next = (next + 1) % samples.size();
+        });
+        std::cout << "  level " << i + 1 << ": " << std::fixed << std::setprecision(1) << ns << " ns per push, "
+                  << deadlocked << " of " << samples.size() << " random pushes deadlocked" << std::endl;
+    }
+}
+
+// The win check as the game used to do it, over a nested vector of tiles.
+bool nestedTileScan(const std::vector<std::vector<TileType>>& tiles) {
+    for (const auto& row : tiles) {
+        for (TileType tile : row) {
+            if (tile == BOX) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool byteScan(const Board& board) {
+    const uint8_t* c = board.data();
+    for (int i = 0; i < board.size(); i++) {
+        if ((c[i] & (CELL_BOX | CELL_GOAL)) == CELL_BOX) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int byteFloodFill(const Board& board, std::vector<uint8_t>& seen, std::vector<int>& queue) {
+    std::fill(seen.begin(), seen.end(), 0);
+    int head = 0;
+    int tail = 0;
+    int start = board.index(board.player().x, board.player().y);
+    queue[tail++] = start;
+    seen[start] = 1;
+    while (head < tail) {
+        int cell = queue[head++];
+        int x = cell % board.width();
+        int y = cell / board.width();
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            int nx = x + DIR_DX[d];
+            int ny = y + DIR_DY[d];
+            if (board.inside(nx, ny) && !seen[board.index(nx, ny)] && board.isFreeAt(board.index(nx, ny))) {
+                seen[board.index(nx, ny)] = 1;
+                queue[tail++] = board.index(nx, ny);
+            }
+        }
+    }
+    return tail;
+}
+
+void benchBitboards(const std::vector<Board>& levels) {
+#if defined(__AVX2__)
+    std::cout << "Bitboards (AVX2)" << std::endl;
+#else
+    std::cout << "Bitboards (scalar)" << std::endl;
+#endif
+    for (size_t i = 0; i < levels.size(); i++) {
+        const Board& board = levels[i];
+        std::vector<std::vector<TileType>> tiles(board.height(), std::vector<TileType>(board.width()));
+        for (int y = 0; y < board.height(); y++) {
+            for (int x = 0; x < board.width(); x++) {
+                tiles[y][x] = board.tileAt(x, y);
+            }
+        }
+        BitboardGeometry geometry(board.width(), board.height());
+        std::vector<uint8_t> seen(board.size());
+        std::vector<int> queue(board.size());
+
+        volatile bool sink = false;
+        volatile int count = 0;
+        double nestedNs = measure([&]() { sink = nestedTileScan(tiles); });
+        double bytesNs = measure([&]() { sink = byteScan(board); });
+        double bitsNs = measure([&]() { sink = board.boxBits().subsetOf(board.goalBits()); });
+        double counterNs = measure([&]() { sink = board.isSolved(); });
+        double bfsNs = measure([&]() { count = byteFloodFill(board, seen, queue); });
+        double fillNs = measure([&]() { count = board.playerReach(geometry).count(); });
+        int start = board.index(board.player().x, board.player().y);
+        double pushesNs = measureBest([&]() { count = board.reachability(start, geometry).canonical; });
+        std::cout << "  level " << i + 1 << ": win check " << std::fixed << std::setprecision(1) << nestedNs
+                  << " ns tiles / " << bytesNs << " ns bytes / " << bitsNs << " ns bitboard / " << counterNs
+                  << " ns counter, reachability "
+                  << bfsNs << " ns BFS / " << fillNs << " ns bitboard / " << pushesNs << " ns with pushes (best of 5)" << std::endl;
+    }
+}
+
+// Writes packs of the built-in levels repeated to a temporary file and streams them back.
+void benchLevelPack(const std::vector<Board>& levels) {
+    std::cout << "Level pack streaming" << std::endl;
+    std::vector<std::string> texts;
+    for (const Board& board : levels) {
+        texts.push_back(formatXsbLevel(board));
+    }
+    std::string path = (std::filesystem::temp_directory_path() / "sokoban-bench-pack.xsb").string();
+    const int packSizes[] = { 1000, 10000, 50000 };
+    for (int packSize : packSizes) {
+        {
+            std::ofstream out(path, std::ios::binary);
+            for (int i = 0; i < packSize; i++) {
+                out << "; " << i + 1 << "\n" << texts[i % texts.size()] << "Title: Level " << i + 1 << "\n\n";
+            }
+        }
+        std::vector<Board> loaded;
+        LevelPackStats stats;
+        loadLevelPack(path, loaded, &stats);
+        std::cout << "  " << packSize << " levels: " << std::fixed << std::setprecision(1) << stats.milliseconds << " ms, "
+                  << std::setprecision(0) << stats.levelsPerSecond() << " levels/s, " << std::setprecision(1)
+                  << stats.megabytesPerSecond() << " MB/s (" << stats.bytes / 1024 << " KiB, " << stats.rejected
+                  << " rejected)" << std::endl;
+    }
+    std::remove(path.c_str());
+}
+
+// Time to the first playable level: eager loading of the whole pack against the indexed pack,
+// once with the index built on the spot and once with the sidecar already on disk.
+void benchPackStartup(const std::vector<Board>& levels) {
+    std::cout << "Level pack startup" << std::endl;
+    std::string path = (std::filesystem::temp_directory_path() / "sokoban-bench-startup.xsb").string();
+    std::string indexPath = IndexedLevelPack::indexPath(path);
+    const int packSizes[] = { 10, 1000, 50000 };
+    for (int packSize : packSizes) {
+        {
+            std::ofstream out(path, std::ios::binary);
+            for (int i = 0; i < packSize; i++) {
+                out << "Title: Level " << i + 1 << "\n" << formatXsbLevel(levels[i % levels.size()]) << "\n";
+            }
+        }
+        std::remove(indexPath.c_str());
+
+        Clock::time_point started = Clock::now();
+        std::vector<Board> loaded;
+        loadLevelPack(path, loaded);
+        double eagerMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+
+        IndexedLevelPack pack;
+        IndexedPackStats coldStats;
+        Board board;
+        started = Clock::now();
+        pack.open(path, &coldStats);
+        pack.load(0, board);
+        double coldMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+
+        IndexedPackStats warmStats;
+        started = Clock::now();
+        pack.open(path, &warmStats);
+        pack.load(0, board);
+        double warmMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+
+        double lastNs = measure([&]() { pack.load(pack.count() - 1, board); }, 0.05);
+        std::cout << "  " << packSize << " levels: eager " << std::fixed << std::setprecision(3) << eagerMs
+                  << " ms, indexed " << coldMs << " ms first run / " << warmMs << " ms with index ("
+                  << (warmStats.rebuilt ? "rebuilt" : "reused") << "), last level on demand "
+                  << std::setprecision(1) << lastNs / 1000.0 << " us" << std::endl;
+    }
+    std::remove(path.c_str());
+    std::remove(indexPath.c_str());
+}
+
+// Drops the file from the page cache where the OS allows it, so the next read is cold.
+bool evictFromCache(const std::string& path) {
+#if defined(__linux__)
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    fdatasync(fd);
+    bool dropped = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+    close(fd);
+    return dropped;
+#else
+    (void)path;
+    return false;
+#endif
+}
+
+// Size of the binary format against the text it was converted from, and the time to open
+// each form and decode every level, first from a cold page cache and then warm.
+void benchBinaryPack(const std::vector<Board>& levels) {
+    std::cout << "Binary level pack" << std::endl;
+    std::string textPath = (std::filesystem::temp_directory_path() / "sokoban-bench-binary.xsb").string();
+    std::string binaryPath = (std::filesystem::temp_directory_path() / "sokoban-bench-binary.sokb").string();
+    const int packSize = 50000;
+    {
+        std::ofstream out(textPath, std::ios::binary);
+        for (int i = 0; i < packSize; i++) {
+            out << "Title: Level " << i + 1 << "\n" << formatXsbLevel(levels[i % levels.size()]) << "\n";
+        }
+    }
+    BinaryPackStats stats;
+    if (!convertToBinaryPack(textPath, binaryPath, &stats)) {
+        return;
+    }
+    std::cout << "  " << stats.levels << " levels: " << stats.textBytes / 1024 << " KiB text, " << stats.binaryBytes / 1024
+              << " KiB binary (" << std::fixed << std::setprecision(1) << 100.0 * stats.binaryBytes / stats.textBytes
+              << "%), converted in " << stats.milliseconds << " ms" << std::endl;
+
+    for (int pass = 0; pass < 2; pass++) {
+        bool cold = pass == 0 && evictFromCache(textPath) && evictFromCache(binaryPath);
+        if (pass == 0 && !cold) {
+            std::cout << "  (page cache could not be dropped; both passes are warm)" << std::endl;
+        }
+        Clock::time_point started = Clock::now();
+        std::vector<Board> loaded;
+        loadLevelPack(textPath, loaded);
+        double textMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+
+        started = Clock::now();
+        BinaryLevelPack pack;
+        pack.open(binaryPath);
+        double openMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        std::vector<Board> decoded(pack.count());
+        for (int i = 0; i < pack.count(); i++) {
+            pack.load(i, decoded[i]);
+        }
+        double binaryMs = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        std::cout << "  " << (pass == 0 ? "cold" : "warm") << ": text " << std::setprecision(1) << textMs << " ms, binary "
+                  << binaryMs << " ms for all levels (open " << std::setprecision(3) << openMs << " ms)" << std::endl;
+    }
+    std::remove(textPath.c_str());
+    std::remove(binaryPath.c_str());
+}
+
+void benchPushDistanceTable(const std::string& title, const Board& board) {
+    double ns = measure([&board]() { PushDistanceTable table(board); }, 0.05);
+    PushDistanceTable table(board);
+    std::cout << "  " << title << " (" << board.width() << "x" << board.height() << ", " << table.goalCount()
+              << " goals): " << std::fixed << std::setprecision(1) << ns / 1000.0 << " us, " << table.memoryBytes() / 1024.0
+              << " KB" << std::endl;
+}
+
+// Build time and size of the push distance tables for the built-in levels and for the largest
+// boards of `packPath`, if one is given.
+void benchPushDistances(const std::vector<Board>& levels, const std::string& packPath) {
+    std::cout << "Push distance tables" << std::endl;
+    for (size_t i = 0; i < levels.size(); i++) {
+        benchPushDistanceTable("level " + std::to_string(i + 1), levels[i]);
+    }
+    if (packPath.empty()) {
+        return;
+    }
+    std::vector<Board> pack;
+    bool loaded = BinaryLevelPack::isBinaryPackPath(packPath) ? loadBinaryPack(packPath, pack) : loadLevelPack(packPath, pack);
+    if (!loaded) {
+        return;
+    }
+    std::vector<size_t> order(pack.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&pack](size_t a, size_t b) { return pack[a].size() > pack[b].size(); });
+    for (size_t k = 0; k < order.size() && k < 5; k++) {
+        benchPushDistanceTable(packPath + " level " + std::to_string(order[k] + 1), pack[order[k]]);
+    }
+}
+
+// Runs A* on every level with the Manhattan matching, solved from scratch per position, and
+// with the push distance matching updated per push, under the same node limit.
+void benchHeuristics(const std::vector<Board>& levels) {
+    std::cout << "A* with Manhattan vs push distance matching (60000 node limit)" << std::endl;
+    const HeuristicKind kinds[] = { HEURISTIC_MANHATTAN, HEURISTIC_PUSHES };
+    const char* names[] = { "manhattan", "pushes" };
+    for (size_t i = 0; i < levels.size(); i++) {
+        std::cout << "  level " << i + 1 << ":";
+        for (int k = 0; k < 2; k++) {
+            SolverOptions options;
+            options.maxNodes = 60000;
+            options.tableBytes = size_t(16) << 20;
+            options.heuristic = kinds[k];
+            SolverResult result = solveLevel(levels[i], options);
+            double nodesPerSecond = result.stats.expanded * 1000.0 / std::max(result.stats.milliseconds, 0.001);
+            std::cout << (k ? ";" : "") << " " << names[k] << " "
+                      << (result.solved ? std::to_string(result.pushes) + " pushes" : std::string("unsolved")) << ", "
+                      << result.stats.expanded << " nodes, " << std::fixed << std::setprecision(0) << nodesPerSecond
+                      << " nodes/s";
+        }
+        std::cout << std::endl;
+    }
+}
+
+}  // namespace
+
+// Usage: sokoban-bench [PACK]
+// PACK, a text or binary pack, adds its largest boards to the push distance table timings.
+int main(int argc, char* argv[]) {
+    std::string packPath = argc > 1 ? argv[1] : "";
+    std::vector<Board> levels = loadBuiltinLevels();
+    benchDeadSquares(levels);
+    benchFreezeDeadlocks(levels);
+    benchBitboards(levels);
+    benchLevelPack(levels);
+    benchPackStartup(levels);
+    benchBinaryPack(levels);
+    benchPushDistances(levels, packPath);
+    benchHeuristics(levels);
+    return 0;
+}
@@ -0,0 +1,263 @@
+#include "binarypack.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include "deadlock.h"
+#include "levelpack.h"
+
+namespace {
+
+const char BINARY_MAGIC[8] = { 'S', 'O', 'K', 'B', 'I', 'N', '1', '\0' };
+const int RECORD_HEADER_BYTES = 6;
+
+void putU16(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(uint8_t(value));
+    out.push_back(uint8_t(value >> 8));
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t value) {
+    putU16(out, value & 0xffff);
+    putU16(out, value >> 16);
+}
+
+void putU64(std::vector<uint8_t>& out, uint64_t value) {
+    putU32(out, uint32_t(value));
+    putU32(out, uint32_t(value >> 32));
+}
+
+uint32_t getU16(const uint8_t* p) { return uint32_t(p[0]) | (uint32_t(p[1]) << 8); }
+uint32_t getU32(const uint8_t* p) { return getU16(p) | (getU16(p + 2) << 16); }
+uint64_t getU64(const uint8_t* p) { return uint64_t(getU32(p)) | (uint64_t(getU32(p + 4)) << 32); }
+
+class BitWriter {
+public:
+    explicit BitWriter(std::vector<uint8_t>& out) : out(out) {}
+
+    void put(bool bit) {
+        if (used == 0) {
+            out.push_back(0);
+        }
+        if (bit) {
+            out.back() |= uint8_t(1 << used);
+        }
+        used = (used + 1) & 7;
+    }
+
+private:
+    std::vector<uint8_t>& out;
+    int used = 0;
+};
+
+class BitReader {
+public:
+    BitReader(const uint8_t* data, size_t length) : data(data), bits(length * 8) {}
+
+    bool take() {
+        bool bit = (data[next >> 3] >> (next & 7)) & 1;
+        next++;
+        return bit;
+    }
+    bool has(size_t count) const { return next + count <= bits; }
+
+private:
+    const uint8_t* data;
+    size_t bits;
+    size_t next = 0;
+};
+
+}  // namespace
+
+void encodeBinaryLevel(const Board& board, std::vector<uint8_t>& out) {
+    Point player = board.player();
+    out.push_back(uint8_t(board.width()));
+    out.push_back(uint8_t(board.height()));
+    putU16(out, uint32_t(board.index(player.x, player.y)));
+    putU16(out, uint32_t(board.boxCount()));
+
+    BitWriter bits(out);
+    for (int i = 0; i < board.size(); i++) {
+        bits.put(board.isWallAt(i));
+    }
+    for (int i = 0; i < board.size(); i++) {
+        if (!board.isWallAt(i)) {
+            bits.put(board.isGoalAt(i));
+        }
+    }
+    for (int i = 0; i < board.size(); i++) {
+        if (!board.isWallAt(i)) {
+            bits.put(board.hasBoxAt(i));
+        }
+    }
+    for (int i = 0; i < board.size(); i++) {
+        if (!board.isWallAt(i)) {
+            bits.put(board.isDeadAt(i));
+        }
+    }
+}
+
+bool decodeBinaryLevel(const uint8_t* record, size_t length, Board& board) {
+    if (length < size_t(RECORD_HEADER_BYTES)) {
+        return false;
+    }
+    int width = record[0];
+    int height = record[1];
+    int player = int(getU16(record + 2));
+    int cells = width * height;
+    if (width == 0 || height == 0 || width > PACK_LEVEL_MAX_SIDE || height > PACK_LEVEL_MAX_SIDE || player >= cells) {
+        return false;
+    }
+
+    BitReader bits(record + RECORD_HEADER_BYTES, length - RECORD_HEADER_BYTES);
+    if (!bits.has(size_t(cells))) {
+        return false;
+    }
+    board = Board(width, height);
+    int open = 0;
+    for (int i = 0; i < cells; i++) {
+        if (bits.take()) {
+            board.setWall(i % width, i / width, true);
+        } else {
+            open++;
+        }
+    }
+    if (!bits.has(size_t(open) * 3) || board.isWallAt(player)) {
+        return false;
+    }
+    const uint8_t planes[3] = { CELL_GOAL, CELL_BOX, CELL_DEAD };
+    for (uint8_t flag : planes) {
+        for (int i = 0; i < cells; i++) {
+            if (!board.isWallAt(i) && bits.take()) {
+                board.setFlag(i % width, i / width, flag, true);
+            }
+        }
+    }
+    board.setPlayer({ player % width, player / width });
+    return true;
+}
+
+bool convertToBinaryPack(const std::string& textPath, const std::string& binaryPath, BinaryPackStats* stats) {
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    std::ifstream in(textPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Unable to open level pack " << textPath << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> records;
+    std::vector<uint64_t> offsets;
+    LevelPackReader reader(in);
+    PackLevel level;
+    while (reader.next(level)) {
+        markDeadSquares(level.board);
+        offsets.push_back(records.size());
+        encodeBinaryLevel(level.board, records);
+    }
+    offsets.push_back(records.size());
+
+    std::vector<uint8_t> header(BINARY_MAGIC, BINARY_MAGIC + sizeof(BINARY_MAGIC));
+    putU32(header, BINARY_PACK_VERSION);
+    putU32(header, uint32_t(offsets.size() - 1));
+    uint64_t recordsStart = header.size() + offsets.size() * sizeof(uint64_t);
+    for (uint64_t offset : offsets) {
+        putU64(header, recordsStart + offset);
+    }
+
+    std::ofstream out(binaryPath, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(header.data()), std::streamsize(header.size()));
+    out.write(reinterpret_cast<const char*>(records.data()), std::streamsize(records.size()));
+    if (!out) {
+        std::cerr << "Unable to write binary pack " << binaryPath << std::endl;
+        return false;
+    }
+    if (stats) {
+        stats->levels = int(offsets.size() - 1);
+        stats->textBytes = reader.stats().bytes;
+        stats->binaryBytes = header.size() + records.size();
+        stats->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    }
+    return true;
+}
+
+bool loadBinaryPack(const std::string& path, std::vector<Board>& levels) {
+    BinaryLevelPack pack;
+    if (!pack.open(path)) {
+        return false;
+    }
+    size_t first = levels.size();
+    levels.resize(first + pack.count());
+    for (int i = 0; i < pack.count(); i++) {
+        if (!pack.load(i, levels[first + i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BinaryLevelPack::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        std::cerr << "Unable to open binary pack " << path << std::endl;
+        return false;
+    }
+    const uint8_t* data = file.data();
+    if (file.size() < size_t(BINARY_PACK_HEADER_BYTES) || std::memcmp(data, BINARY_MAGIC, sizeof(BINARY_MAGIC)) != 0 ||
+        getU32(data + 8) != BINARY_PACK_VERSION) {
+        std::cerr << path << " is not a version " << BINARY_PACK_VERSION << " binary pack" << std::endl;
+        close();
+        return false;
+    }
+    uint64_t count = getU32(data + 12);
+    if (BINARY_PACK_HEADER_BYTES + (count + 1) * sizeof(uint64_t) > file.size()) {
+        std::cerr << path << " is truncated" << std::endl;
+        close();
+        return false;
+    }
+    levelCount = int(count);
+    return true;
+}
+
+void BinaryLevelPack::close() {
+    file.close();
+    levelCount = 0;
+}
+
+bool BinaryLevelPack::record(int i, const uint8_t*& data, size_t& length) const {
+    const uint8_t* offsets = file.data() + BINARY_PACK_HEADER_BYTES;
+    uint64_t begin = getU64(offsets + size_t(i) * sizeof(uint64_t));
+    uint64_t end = getU64(offsets + size_t(i + 1) * sizeof(uint64_t));
+    if (begin > end || end > file.size()) {
+        return false;
+    }
+    data = file.data() + begin;
+    length = size_t(end - begin);
+    return true;
+}
+
+bool BinaryLevelPack::info(int i, int& width, int& height, int& boxes) const {
+    const uint8_t* data;
+    size_t length;
+    if (!record(i, data, length) || length < size_t(RECORD_HEADER_BYTES)) {
+        return false;
+    }
+    width = data[0];
+    height = data[1];
+    boxes = int(getU16(data + 4));
+    return true;
+}
+
+bool BinaryLevelPack::load(int i, Board& board) const {
+    const uint8_t* data;
+    size_t length;
+    if (!record(i, data, length) || !decodeBinaryLevel(data, length, board)) {
+        std::cerr << "Level " << i + 1 << " of the binary pack is corrupt" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool BinaryLevelPack::isBinaryPackPath(const std::string& path) {
+    static const char extension[] = ".sokb";
+    size_t n = sizeof(extension) - 1;
+    return path.size() >= n && path.compare(path.size() - n, n, extension) == 0;
+}
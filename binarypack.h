@@ -0,0 +1,65 @@
+#ifndef SOKOBAN_BINARYPACK_H
+#define SOKOBAN_BINARYPACK_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "mappedfile.h"
+
+
+// Binary level pack (".sokb"), all integers little-endian:
+//   header   "SOKBIN1\0", uint32 version, uint32 level count
+//   offsets  uint64[count + 1], byte offset of every level record and of the end of the last
+//   record   uint8 width, uint8 height, uint16 player cell, uint16 box count, then a bit stream
+//            (LSB first, padded to a byte): one wall bit per cell, followed by goal, box and
+//            dead-square bits for the non-wall cells only.
+// Dead squares are stored so decoding does not have to run markDeadSquares() again.
+const uint32_t BINARY_PACK_VERSION = 1;
+const int BINARY_PACK_HEADER_BYTES = 16;
+
+
+struct BinaryPackStats {
+    int levels = 0;
+    uint64_t textBytes = 0;
+    uint64_t binaryBytes = 0;
+    double milliseconds = 0.0;
+};
+
+
+// Appends the record for `board` (dead squares already marked) to `out`.
+void encodeBinaryLevel(const Board& board, std::vector<uint8_t>& out);
+
+// Decodes one record. Returns false if it is truncated or describes an impossible board.
+bool decodeBinaryLevel(const uint8_t* record, size_t length, Board& board);
+
+// Streams the text pack at `textPath` and writes its valid levels to `binaryPath`.
+bool convertToBinaryPack(const std::string& textPath, const std::string& binaryPath, BinaryPackStats* stats = nullptr);
+
+// Decodes every level of the binary pack at `path` into `levels`.
+bool loadBinaryPack(const std::string& path, std::vector<Board>& levels);
+
+
+// A binary pack read in place from a memory mapping; records are decoded on demand.
+class BinaryLevelPack {
+public:
+    bool open(const std::string& path);
+    void close();
+
+    int count() const { return levelCount; }
+
+    // Width, height and box count from the record header, without decoding the cells.
+    bool info(int i, int& width, int& height, int& boxes) const;
+
+    bool load(int i, Board& board) const;
+
+    static bool isBinaryPackPath(const std::string& path);
+
+private:
+    bool record(int i, const uint8_t*& data, size_t& length) const;
+
+    MappedFile file;
+    int levelCount = 0;
+};
+
+#endif
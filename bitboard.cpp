@@ -0,0 +1,274 @@
+#include "bitboard.h"
+
+int Bitboard::count() const {
+    int total = 0;
+    for (int w = 0; w < BITBOARD_WORDS; w++) {
+        total += __builtin_popcountll(words[w]);
+    }
+    return total;
+}
+
+int Bitboard::first() const {
+    for (int w = 0; w < BITBOARD_WORDS; w++) {
+        if (words[w]) {
+            return w * 64 + __builtin_ctzll(words[w]);
+        }
+    }
+    return -1;
+}
+
+Bitboard Bitboard::shifted(int cells) const {
+    Bitboard r;
+    if (cells > 0 && cells < 64) {
+        r.words[0] = words[0] << cells;
+        for (int w = 1; w < BITBOARD_WORDS; w++) {
+            r.words[w] = (words[w] << cells) | (words[w - 1] >> (64 - cells));
+        }
+        return r;
+    }
+    if (cells < 0 && cells > -64) {
+        int amount = -cells;
+        for (int w = 0; w < BITBOARD_WORDS - 1; w++) {
+            r.words[w] = (words[w] >> amount) | (words[w + 1] << (64 - amount));
+        }
+        r.words[BITBOARD_WORDS - 1] = words[BITBOARD_WORDS - 1] >> amount;
+        return r;
+    }
+
+    // Whole-word part first, then the remaining bits through the paths above.
+    int wordShift = (cells < 0 ? -cells : cells) >> 6;
+    for (int w = 0; w < BITBOARD_WORDS; w++) {
+        int src = cells < 0 ? w + wordShift : w - wordShift;
+        r.words[w] = src >= 0 && src < BITBOARD_WORDS ? words[src] : 0;
+    }
+    int rest = cells < 0 ? -((-cells) & 63) : cells & 63;
+    return rest ? r.shifted(rest) : r;
+}
+
+
+namespace {
+
+// Row y of `cells` in the low `width` bits; a row spans at most two words.
+uint64_t rowBits(const Bitboard& cells, int y, int width, uint64_t mask) {
+    int first = y * width;
+    int w = first >> 6;
+    int shift = first & 63;
+    uint64_t bits = cells.words[w] >> shift;
+    if (shift + width > 64) {
+        bits |= cells.words[w + 1] << (64 - shift);
+    }
+    return bits & mask;
+}
+
+void addRowBits(Bitboard& cells, int y, int width, uint64_t bits) {
+    int first = y * width;
+    int w = first >> 6;
+    int shift = first & 63;
+    cells.words[w] |= bits << shift;
+    if (shift + width > 64) {
+        cells.words[w + 1] |= bits >> (64 - shift);
+    }
+}
+
+// Every cell of `open` in the same run as a cell of `seeds`, for one row. Eastwards it is a
+// single add: a seed bit carries up through the open cells above it and stops at the first
+// closed one (`east` leaves out the last column, so the carry never wraps). Westwards the
+// seeds spread by doubling shifts, enough of them to cross the whole row.
+uint64_t fillRow(uint64_t seeds, uint64_t open, uint64_t east, int width) {
+    uint64_t region = (((east + seeds) ^ east) & open) | seeds;
+    uint64_t through = open;
+    region |= through & (region >> 1);
+    through &= through >> 1;
+    region |= through & (region >> 2);
+    through &= through >> 2;
+    region |= through & (region >> 4);
+    through &= through >> 4;
+    region |= through & (region >> 8);
+    through &= through >> 8;
+    region |= through & (region >> 16);
+    if (width > 32) {
+        through &= through >> 16;
+        region |= through & (region >> 32);
+    }
+    return region;
+}
+
+}  // namespace
+
+
+BitboardGeometry::BitboardGeometry(int width, int height)
+    : width(width), height(height) {
+    inside.clear();
+    notFirstColumn.clear();
+    notLastColumn.clear();
+    if (!fits(width, height)) {
+        return;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++) {
+            int i = y * width + x;
+            inside.set(i);
+            if (x > 0) {
+                notFirstColumn.set(i);
+            }
+            if (x < width - 1) {
+                notLastColumn.set(i);
+            }
+        }
+    }
+}
+
+Bitboard BitboardGeometry::neighbours(const Bitboard& cells) const {
+    if (width >= 64) {
+        // The per-word version below assumes a row fits in one word.
+        return step(cells, 1, 0) | step(cells, -1, 0) | step(cells, 0, 1) | step(cells, 0, -1);
+    }
+
+    // Written per word rather than with shifted(), it is called once per flood fill iteration.
+    const int last = BITBOARD_WORDS - 1;
+    const int up = 64 - width;
+    Bitboard r;
+    for (int w = 0; w < BITBOARD_WORDS; w++) {
+        uint64_t c = cells.words[w];
+        uint64_t east = (c & notLastColumn.words[w]) << 1;
+        uint64_t west = (c & notFirstColumn.words[w]) >> 1;
+        uint64_t south = c << width;
+        uint64_t north = c >> width;
+        if (w > 0) {
+            east |= (cells.words[w - 1] & notLastColumn.words[w - 1]) >> 63;
+            south |= cells.words[w - 1] >> up;
+        }
+        if (w < last) {
+            west |= (cells.words[w + 1] & notFirstColumn.words[w + 1]) << 63;
+            north |= cells.words[w + 1] << up;
+        }
+        r.words[w] = (east | west | south | north) & inside.words[w];
+    }
+    return r;
+}
+
+Bitboard BitboardGeometry::step(const Bitboard& cells, int dx, int dy) const {
+    Bitboard moved = cells;
+    if (dx > 0) {
+        moved = moved & notLastColumn;
+    } else if (dx < 0) {
+        moved = moved & notFirstColumn;
+    }
+    return moved.shifted(dx + dy * width) & inside;
+}
+
+void BitboardGeometry::pushes(const Bitboard& boxes, const Bitboard& reached, const Bitboard& free,
+                              Bitboard out[4]) const {
+    const int dx[4] = { -1, 0, 1, 0 };
+    const int dy[4] = { 0, -1, 0, 1 };
+    if (width >= 64) {
+        for (int k = 0; k < 4; k++) {
+            out[k] = boxes & step(reached, dx[k], dy[k]) & step(free, -dx[k], -dy[k]);
+        }
+        return;
+    }
+
+    // Each cell's four neighbours, shifted onto it from both sets at once: `fromWest` is the
+    // cell at index - 1, which must not be in the last column, and so on.
+    const int used = (width * height + 63) / 64;
+    const int up = 64 - width;
+    for (int k = 0; k < 4; k++) {
+        out[k].clear();
+    }
+    for (int w = 0; w < used; w++) {
+        uint64_t reachedWest = (reached.words[w] & notLastColumn.words[w]) << 1;
+        uint64_t freeWest = (free.words[w] & notLastColumn.words[w]) << 1;
+        uint64_t reachedEast = (reached.words[w] & notFirstColumn.words[w]) >> 1;
+        uint64_t freeEast = (free.words[w] & notFirstColumn.words[w]) >> 1;
+        uint64_t reachedNorth = reached.words[w] << width;
+        uint64_t freeNorth = free.words[w] << width;
+        uint64_t reachedSouth = reached.words[w] >> width;
+        uint64_t freeSouth = free.words[w] >> width;
+        if (w > 0) {
+            reachedWest |= (reached.words[w - 1] & notLastColumn.words[w - 1]) >> 63;
+            freeWest |= (free.words[w - 1] & notLastColumn.words[w - 1]) >> 63;
+            reachedNorth |= reached.words[w - 1] >> up;
+            freeNorth |= free.words[w - 1] >> up;
+        }
+        if (w + 1 < used) {
+            reachedEast |= (reached.words[w + 1] & notFirstColumn.words[w + 1]) << 63;
+            freeEast |= (free.words[w + 1] & notFirstColumn.words[w + 1]) << 63;
+            reachedSouth |= reached.words[w + 1] << up;
+            freeSouth |= free.words[w + 1] << up;
+        }
+        uint64_t box = boxes.words[w];
+        out[0].words[w] = box & reachedEast & freeWest;
+        out[1].words[w] = box & reachedSouth & freeNorth;
+        out[2].words[w] = box & reachedWest & freeEast;
+        out[3].words[w] = box & reachedNorth & freeSouth;
+    }
+}
+
+Bitboard BitboardGeometry::floodFill(const Bitboard& seed, const Bitboard& passable) const {
+    if (width > 64 || height > 64) {
+        Bitboard region = seed & passable;
+        while (true) {
+            Bitboard grown = region | (neighbours(region) & passable);
+            if (grown == region) {
+                return region;
+            }
+            region = grown;
+        }
+    }
+
+    // One word per row, with an empty row above and below so every row has two neighbours.
+    const uint64_t mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+    const uint64_t allRows = height == 64 ? ~uint64_t(0) : (uint64_t(1) << height) - 1;
+    uint64_t open[66];
+    uint64_t region[66];
+    region[0] = 0;
+    region[height + 1] = 0;
+    for (int y = 0; y < height; y++) {
+        region[y + 1] = 0;
+    }
+    // Rows are read from `passable` the first time they are looked at; most fills touch few.
+    uint64_t loaded = 0;
+    // Seeds are usually a single cell, so they are placed bit by bit.
+    uint64_t dirty = 0;
+    for (int w = 0; w < BITBOARD_WORDS; w++) {
+        for (uint64_t bits = seed.words[w] & passable.words[w]; bits; bits &= bits - 1) {
+            int i = w * 64 + __builtin_ctzll(bits);
+            region[i / width + 1] |= uint64_t(1) << (i % width);
+            dirty |= uint64_t(1) << (i / width);
+        }
+    }
+
+    // `dirty` holds the rows that may have gained cells from a neighbour; `filled` the rows
+    // with any cell at all.
+    uint64_t filled = dirty;
+    loaded = dirty;
+    for (uint64_t rows = dirty; rows; rows &= rows - 1) {
+        int y = __builtin_ctzll(rows);
+        open[y] = rowBits(passable, y, width, mask);
+        region[y + 1] = fillRow(region[y + 1], open[y], open[y] & (mask >> 1), width);
+    }
+    dirty = ((dirty >> 1) | (dirty << 1)) & allRows;
+    while (dirty) {
+        int y = __builtin_ctzll(dirty);
+        dirty &= dirty - 1;
+        uint64_t* row = region + y + 1;
+        if (!(loaded >> y & 1)) {
+            open[y] = rowBits(passable, y, width, mask);
+            loaded |= uint64_t(1) << y;
+        }
+        uint64_t entering = (row[-1] | row[1]) & open[y] & ~row[0];
+        if (entering) {
+            row[0] |= fillRow(entering, open[y], open[y] & (mask >> 1), width);
+            filled |= uint64_t(1) << y;
+            dirty |= ((uint64_t(1) << y) >> 1 | (uint64_t(1) << y) << 1) & allRows;
+        }
+    }
+
+    Bitboard cells;
+    cells.clear();
+    for (; filled; filled &= filled - 1) {
+        int y = __builtin_ctzll(filled);
+        addRowBits(cells, y, width, region[y + 1]);
+    }
+    return cells;
+}
@@ -0,0 +1,183 @@
+#ifndef SOKOBAN_BITBOARD_H
+#define SOKOBAN_BITBOARD_H
+
+#include <cstdint>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+
+// One bit per cell in the same row-major order as Board. A 24x14 level needs six words;
+// eight keep the size a whole number of AVX2 registers. Boards with more cells than this
+// fall back to the byte array.
+const int BITBOARD_WORDS = 8;
+const int BITBOARD_CELLS = BITBOARD_WORDS * 64;
+
+
+struct alignas(32) Bitboard {
+    uint64_t words[BITBOARD_WORDS];
+
+    void clear() {
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            words[w] = 0;
+        }
+    }
+
+    bool test(int i) const { return (words[i >> 6] >> (i & 63)) & 1; }
+    void set(int i) { words[i >> 6] |= uint64_t(1) << (i & 63); }
+    void reset(int i) { words[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+    void assign(int i, bool on) {
+        if (on) {
+            set(i);
+        } else {
+            reset(i);
+        }
+    }
+
+    int count() const;
+    int first() const;  // lowest set cell, -1 if none
+
+    // Every cell moved `cells` positions towards higher indices (lower if negative).
+    // Bits moved past either end are dropped.
+    Bitboard shifted(int cells) const;
+
+#if defined(__AVX2__)
+    __m256i lane(int k) const { return _mm256_load_si256(reinterpret_cast<const __m256i*>(words) + k); }
+    void setLane(int k, __m256i v) { _mm256_store_si256(reinterpret_cast<__m256i*>(words) + k, v); }
+
+    Bitboard operator&(const Bitboard& o) const {
+        Bitboard r;
+        for (int k = 0; k < BITBOARD_WORDS / 4; k++) {
+            r.setLane(k, _mm256_and_si256(lane(k), o.lane(k)));
+        }
+        return r;
+    }
+
+    Bitboard operator|(const Bitboard& o) const {
+        Bitboard r;
+        for (int k = 0; k < BITBOARD_WORDS / 4; k++) {
+            r.setLane(k, _mm256_or_si256(lane(k), o.lane(k)));
+        }
+        return r;
+    }
+
+    // this & ~o
+    Bitboard andNot(const Bitboard& o) const {
+        Bitboard r;
+        for (int k = 0; k < BITBOARD_WORDS / 4; k++) {
+            r.setLane(k, _mm256_andnot_si256(o.lane(k), lane(k)));
+        }
+        return r;
+    }
+
+    bool operator==(const Bitboard& o) const {
+        __m256i diff = _mm256_setzero_si256();
+        for (int k = 0; k < BITBOARD_WORDS / 4; k++) {
+            diff = _mm256_or_si256(diff, _mm256_xor_si256(lane(k), o.lane(k)));
+        }
+        return _mm256_testz_si256(diff, diff) != 0;
+    }
+
+    bool none() const {
+        __m256i any = _mm256_setzero_si256();
+        for (int k = 0; k < BITBOARD_WORDS / 4; k++) {
+            any = _mm256_or_si256(any, lane(k));
+        }
+        return _mm256_testz_si256(any, any) != 0;
+    }
+
+    // No bit set here that is clear in `o`.
+    bool subsetOf(const Bitboard& o) const {
+        int inside = 1;
+        for (int k = 0; k < BITBOARD_WORDS / 4; k++) {
+            inside &= _mm256_testc_si256(o.lane(k), lane(k));
+        }
+        return inside != 0;
+    }
+#else
+    Bitboard operator&(const Bitboard& o) const {
+        Bitboard r;
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            r.words[w] = words[w] & o.words[w];
+        }
+        return r;
+    }
+
+    Bitboard operator|(const Bitboard& o) const {
+        Bitboard r;
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            r.words[w] = words[w] | o.words[w];
+        }
+        return r;
+    }
+
+    // this & ~o
+    Bitboard andNot(const Bitboard& o) const {
+        Bitboard r;
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            r.words[w] = words[w] & ~o.words[w];
+        }
+        return r;
+    }
+
+    bool operator==(const Bitboard& o) const {
+        uint64_t diff = 0;
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            diff |= words[w] ^ o.words[w];
+        }
+        return diff == 0;
+    }
+
+    bool none() const {
+        uint64_t any = 0;
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            any |= words[w];
+        }
+        return any == 0;
+    }
+
+    // No bit set here that is clear in `o`.
+    bool subsetOf(const Bitboard& o) const {
+        uint64_t outside = 0;
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            outside |= words[w] & ~o.words[w];
+        }
+        return outside == 0;
+    }
+#endif
+
+    bool operator!=(const Bitboard& o) const { return !(*this == o); }
+};
+
+
+// Column masks for one board size, so horizontal shifts do not wrap from one row into the next.
+class BitboardGeometry {
+public:
+    BitboardGeometry(int width, int height);
+
+    static bool fits(int width, int height) { return width * height <= BITBOARD_CELLS; }
+
+    // The four neighbours of every cell in `cells`.
+    Bitboard neighbours(const Bitboard& cells) const;
+
+    // Every cell of `cells` moved by (dx, dy); cells that would leave the board are dropped.
+    Bitboard step(const Bitboard& cells, int dx, int dy) const;
+
+    // For each step west, north, east and south in turn, the cells of `boxes` with the cell
+    // behind them in `reached` and the cell ahead in `free`: the boxes a player standing in
+    // `reached` can push that way. One pass over the words computes all four.
+    void pushes(const Bitboard& boxes, const Bitboard& reached, const Bitboard& free, Bitboard out[4]) const;
+
+    // All cells of `passable` connected to `seed`. Boards up to 64 cells wide and 64 rows high
+    // are filled a row at a time: a row takes in its neighbours' cells and is spread along its
+    // runs in a handful of word operations, and only rows next to a changed row are revisited.
+    Bitboard floodFill(const Bitboard& seed, const Bitboard& passable) const;
+
+    int width;
+    int height;
+    Bitboard inside;
+    Bitboard notFirstColumn;
+    Bitboard notLastColumn;
+};
+
+#endif
@@ -0,0 +1,229 @@
+#include "board.h"
+
+#include <algorithm>
+#include <cstring>
+
+Board::Board()
+    : w(0), h(0), offGoalCount(0), playerPos{ 0, 0 } {
+    wallLayer.clear();
+    goalLayer.clear();
+    boxLayer.clear();
+}
+
+Board::Board(int width, int height)
+    : w(width), h(height), offGoalCount(0), cells(size_t(width) * height, 0), playerPos{ 0, 0 } {
+    wallLayer.clear();
+    goalLayer.clear();
+    boxLayer.clear();
+}
+
+void Board::setFlag(int x, int y, uint8_t flag, bool on) {
+    int i = index(x, y);
+    uint8_t& c = cells[i];
+    bool wasOffGoal = (c & (CELL_BOX | CELL_GOAL)) == CELL_BOX;
+    if (on) {
+        c |= flag;
+    } else {
+        c &= uint8_t(~flag);
+    }
+    offGoalCount += int((c & (CELL_BOX | CELL_GOAL)) == CELL_BOX) - int(wasOffGoal);
+    if (i < BITBOARD_CELLS) {
+        wallLayer.assign(i, (c & CELL_WALL) != 0);
+        goalLayer.assign(i, (c & CELL_GOAL) != 0);
+        boxLayer.assign(i, (c & CELL_BOX) != 0);
+    }
+}
+
+int Board::cellSprites(int x, int y, TileType layers[3]) const {
+    uint8_t c = cell(x, y);
+    int count = 0;
+    layers[count++] = (c & CELL_WALL) ? WALL : ((c & CELL_GOAL) ? STORAGE : EMPTY);
+    TileType type = tileAt(x, y);
+    if (type == BOX || type == BOX_ON_STORAGE || type == PLAYER || type == PLAYER_ON_STORAGE) {
+        layers[count++] = type;
+    }
+    if (type == PLAYER || type == PLAYER_ON_STORAGE) {
+        layers[count++] = PLAYER;
+    }
+    return count;
+}
+
+TileType Board::tileAt(int x, int y) const {
+    uint8_t c = cell(x, y);
+    if (c & CELL_WALL) {
+        return WALL;
+    }
+    bool goal = (c & CELL_GOAL) != 0;
+    if (c & CELL_BOX) {
+        return goal ? BOX_ON_STORAGE : BOX;
+    }
+    if (playerPos.x == x && playerPos.y == y) {
+        return goal ? PLAYER_ON_STORAGE : PLAYER;
+    }
+    return goal ? STORAGE : EMPTY;
+}
+
+int Board::boxCount() const {
+    int count = 0;
+    for (uint8_t c : cells) {
+        if (c & CELL_BOX) {
+            count++;
+        }
+    }
+    return count;
+}
+
+int Board::goalCount() const {
+    int count = 0;
+    for (uint8_t c : cells) {
+        if (c & CELL_GOAL) {
+            count++;
+        }
+    }
+    return count;
+}
+
+bool Board::movePlayer(int dx, int dy, bool* pushed) {
+    int newX = playerPos.x + dx;
+    int newY = playerPos.y + dy;
+    if (pushed) {
+        *pushed = false;
+    }
+
+    if (!inside(newX, newY) || isWall(newX, newY)) {
+        return false;
+    }
+
+    if (hasBox(newX, newY)) {
+        int nextX = newX + dx;
+        int nextY = newY + dy;
+        if (!inside(nextX, nextY)) {
+            return false;
+        }
+        if (isWall(nextX, nextY) || hasBox(nextX, nextY)) {
+            return false;
+        }
+
+        setBox(nextX, nextY, true);
+        setBox(newX, newY, false);
+        if (pushed) {
+            *pushed = true;
+        }
+    }
+
+    playerPos = { newX, newY };
+    return true;
+}
+
+void Board::undoMove(int dx, int dy, bool pushed) {
+    if (pushed) {
+        setBox(playerPos.x + dx, playerPos.y + dy, false);
+        setBox(playerPos.x, playerPos.y, true);
+    }
+    playerPos = { playerPos.x - dx, playerPos.y - dy };
+}
+
+Bitboard Board::playerReach(const BitboardGeometry& geometry) const {
+    return reachFrom(index(playerPos.x, playerPos.y), geometry);
+}
+
+Bitboard Board::reachFrom(int from, const BitboardGeometry& geometry) const {
+    Bitboard seed;
+    seed.clear();
+    seed.set(from);
+    return geometry.floodFill(seed, geometry.inside.andNot(wallLayer | boxLayer));
+}
+
+Reachability Board::reachability(int from, const BitboardGeometry& geometry) const {
+    Reachability reach;
+    Bitboard seed;
+    seed.clear();
+    seed.set(from);
+    Bitboard free = geometry.inside.andNot(wallLayer | boxLayer);
+    reach.cells = geometry.floodFill(seed, free);
+    reach.canonical = reach.cells.first();
+    geometry.pushes(boxLayer, reach.cells, free, reach.pushes);
+    return reach;
+}
+
+void Board::resetFrom(const Board& other) {
+    if (cells.size() == other.cells.size()) {
+        std::memcpy(cells.data(), other.cells.data(), cells.size());
+    } else {
+        cells = other.cells;
+    }
+    w = other.w;
+    h = other.h;
+    offGoalCount = other.offGoalCount;
+    playerPos = other.playerPos;
+    wallLayer = other.wallLayer;
+    goalLayer = other.goalLayer;
+    boxLayer = other.boxLayer;
+}
+
+bool Board::walkPath(Point target, std::vector<int>& steps) const {
+    steps.clear();
+    if (!inside(target.x, target.y)) {
+        return false;
+    }
+    int start = index(playerPos.x, playerPos.y);
+    int goal = index(target.x, target.y);
+    if (hasBitboards()) {
+        BitboardGeometry geometry(w, h);
+        Reachability reach = reachability(start, geometry);
+        if (!reach.cells.test(goal)) {
+            return false;
+        }
+        // Rings of cells one step further from the player each, until one holds the target;
+        // the path is read back from the target through the rings.
+        std::vector<Bitboard> rings(1);
+        rings[0].clear();
+        rings[0].set(start);
+        Bitboard seen = rings[0];
+        while (!rings.back().test(goal)) {
+            Bitboard next = (geometry.neighbours(rings.back()) & reach.cells).andNot(seen);
+            seen = seen | next;
+            rings.push_back(next);
+        }
+        steps.resize(rings.size() - 1);
+        Point cell = target;
+        for (size_t k = rings.size() - 1; k > 0; k--) {
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                Point previous = { cell.x - DIR_DX[d], cell.y - DIR_DY[d] };
+                if (inside(previous.x, previous.y) && rings[k - 1].test(index(previous.x, previous.y))) {
+                    steps[k - 1] = d;
+                    cell = previous;
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Too large for a bitboard: breadth-first over the bytes, remembering how each cell was
+    // entered.
+    std::vector<int8_t> entered(cells.size(), -1);
+    std::vector<int> queue;
+    queue.push_back(start);
+    entered[start] = DIRECTION_COUNT;
+    for (size_t head = 0; head < queue.size() && entered[goal] < 0; head++) {
+        int x = queue[head] % w;
+        int y = queue[head] / w;
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            int nx = x + DIR_DX[d];
+            int ny = y + DIR_DY[d];
+            if (inside(nx, ny) && entered[index(nx, ny)] < 0 && isFreeAt(index(nx, ny))) {
+                entered[index(nx, ny)] = int8_t(d);
+                queue.push_back(index(nx, ny));
+            }
+        }
+    }
+    if (entered[goal] < 0) {
+        return false;
+    }
+    for (int cell = goal; cell != start; cell -= offset(entered[cell])) {
+        steps.push_back(entered[cell]);
+    }
+    std::reverse(steps.begin(), steps.end());
+    return true;
+}
@@ -0,0 +1,162 @@
+#ifndef SOKOBAN_BOARD_H
+#define SOKOBAN_BOARD_H
+
+#include <cstdint>
+#include <vector>
+#include "bitboard.h"
+
+
+enum TileType { EMPTY, WALL, BOX, PLAYER, STORAGE, BOX_ON_STORAGE, PLAYER_ON_STORAGE };
+
+
+struct Point {
+    int x, y;
+};
+
+
+// Each cell is one byte: the static layer (walls, goals, dead squares) never changes after
+// loading, the dynamic layer (boxes) is what movePlayer() rewrites. The player is kept as a point.
+enum CellFlag : uint8_t {
+    CELL_WALL = 1 << 0,
+    CELL_GOAL = 1 << 1,
+    CELL_BOX = 1 << 2,
+    CELL_DEAD = 1 << 3  // a box here can never reach a goal, see markDeadSquares()
+};
+
+const uint8_t CELL_STATIC_MASK = CELL_WALL | CELL_GOAL | CELL_DEAD;
+const uint8_t CELL_DYNAMIC_MASK = CELL_BOX;
+
+
+// Directions in LURD order. Move strings use the lowercase letter for a walk
+// and the uppercase letter for a push.
+enum Direction { DIR_LEFT, DIR_UP, DIR_RIGHT, DIR_DOWN };
+
+const int DIRECTION_COUNT = 4;
+const int DIR_DX[DIRECTION_COUNT] = { -1, 0, 1, 0 };
+const int DIR_DY[DIRECTION_COUNT] = { 0, -1, 0, 1 };
+const char DIR_MOVE_CHAR[DIRECTION_COUNT] = { 'l', 'u', 'r', 'd' };
+const char DIR_PUSH_CHAR[DIRECTION_COUNT] = { 'L', 'U', 'R', 'D' };
+
+// The direction of a unit step (dx, dy), or -1 if it is not one.
+inline int directionOf(int dx, int dy) {
+    for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+        if (DIR_DX[dir] == dx && DIR_DY[dir] == dy) {
+            return dir;
+        }
+    }
+    return -1;
+}
+
+
+// What the player can do from one cell without pushing, see Board::reachability().
+struct Reachability {
+    Bitboard cells;                    // every cell the player can walk to
+    int canonical;                     // the smallest of them, -1 if none: one position per region
+    Bitboard pushes[DIRECTION_COUNT];  // per direction, the boxes the player can push that way
+};
+
+
+class Board {
+public:
+    Board();
+    Board(int width, int height);
+
+    int width() const { return w; }
+    int height() const { return h; }
+    int size() const { return w * h; }
+    int index(int x, int y) const { return y * w + x; }
+    bool inside(int x, int y) const { return x >= 0 && x < w && y >= 0 && y < h; }
+
+    uint8_t cell(int x, int y) const { return cells[index(x, y)]; }
+    uint8_t cellAt(int i) const { return cells[i]; }
+    int offset(int dir) const { return DIR_DX[dir] + DIR_DY[dir] * w; }
+    bool isWall(int x, int y) const { return (cell(x, y) & CELL_WALL) != 0; }
+    bool isGoal(int x, int y) const { return (cell(x, y) & CELL_GOAL) != 0; }
+    bool hasBox(int x, int y) const { return (cell(x, y) & CELL_BOX) != 0; }
+    bool isDead(int x, int y) const { return (cell(x, y) & CELL_DEAD) != 0; }
+
+    void setFlag(int x, int y, uint8_t flag, bool on);
+    void setWall(int x, int y, bool on) { setFlag(x, y, CELL_WALL, on); }
+    void setGoal(int x, int y, bool on) { setFlag(x, y, CELL_GOAL, on); }
+    void setBox(int x, int y, bool on) { setFlag(x, y, CELL_BOX, on); }
+
+    // Index-based access for code that walks the grid with offset() instead of coordinates.
+    bool isWallAt(int i) const { return (cells[i] & CELL_WALL) != 0; }
+    bool isGoalAt(int i) const { return (cells[i] & CELL_GOAL) != 0; }
+    bool hasBoxAt(int i) const { return (cells[i] & CELL_BOX) != 0; }
+    bool isDeadAt(int i) const { return (cells[i] & CELL_DEAD) != 0; }
+    bool isFreeAt(int i) const { return (cells[i] & (CELL_WALL | CELL_BOX)) == 0; }
+    void setBoxAt(int i, bool on) {
+        bool wasOffGoal = (cells[i] & (CELL_BOX | CELL_GOAL)) == CELL_BOX;
+        if (on) {
+            cells[i] |= CELL_BOX;
+        } else {
+            cells[i] &= uint8_t(~CELL_BOX);
+        }
+        offGoalCount += int((cells[i] & (CELL_BOX | CELL_GOAL)) == CELL_BOX) - int(wasOffGoal);
+        if (i < BITBOARD_CELLS) {
+            boxLayer.assign(i, on);
+        }
+    }
+
+    // Walls, goals and boxes mirrored as bitboards, kept in sync by the setters above.
+    // Only valid when hasBitboards(), i.e. the board has at most BITBOARD_CELLS cells.
+    bool hasBitboards() const { return BitboardGeometry::fits(w, h); }
+    const Bitboard& wallBits() const { return wallLayer; }
+    const Bitboard& goalBits() const { return goalLayer; }
+    const Bitboard& boxBits() const { return boxLayer; }
+
+    // Cells the player can walk to without pushing, by bitboard flood fill.
+    Bitboard playerReach(const BitboardGeometry& geometry) const;
+    Bitboard reachFrom(int from, const BitboardGeometry& geometry) const;
+
+    // reachFrom() plus its canonical cell and the legal pushes: a box can be pushed in
+    // direction d when the player reaches the cell behind it and the cell ahead is free.
+    Reachability reachability(int from, const BitboardGeometry& geometry) const;
+
+    // The directions of a shortest walk from the player to `target` that pushes nothing, found
+    // with reachability() on boards that fit a bitboard and a byte BFS on larger ones. Returns
+    // false if `target` cannot be reached that way.
+    bool walkPath(Point target, std::vector<int>& steps) const;
+
+    Point player() const { return playerPos; }
+    void setPlayer(Point p) { playerPos = p; }
+
+    TileType tileAt(int x, int y) const;
+
+    // The sprites drawn for cell (x, y), bottom to top: floor, wall or goal, then the box or
+    // the player tile, then the plain player sprite over a player. Returns how many were
+    // written to `layers` (at most 3).
+    int cellSprites(int x, int y, TileType layers[3]) const;
+
+    // Every box is on a goal. The setters keep a running count of boxes off goal, so this is O(1).
+    bool isSolved() const { return offGoalCount == 0; }
+    int boxesOffGoal() const { return offGoalCount; }
+    int boxCount() const;
+    int goalCount() const;
+
+    // The game rules: step the player by (dx, dy), pushing a single box if one is in the way.
+    // Returns false and leaves the board untouched if the move is blocked.
+    bool movePlayer(int dx, int dy, bool* pushed = nullptr);
+
+    // Takes back the last successful movePlayer(dx, dy): steps the player back and, if that
+    // move pushed a box, pulls the box back with it. Only valid for the most recent move.
+    void undoMove(int dx, int dy, bool pushed);
+
+    // Restores this board to the state of `other`; boards of the same size are a single memcpy
+    // of the cells plus a copy of the bitboards.
+    void resetFrom(const Board& other);
+
+    const uint8_t* data() const { return cells.data(); }
+
+private:
+    int w, h;
+    int offGoalCount;
+    std::vector<uint8_t> cells;
+    Point playerPos;
+    Bitboard wallLayer;
+    Bitboard goalLayer;
+    Bitboard boxLayer;
+};
+
+#endif
@@ -0,0 +1,176 @@
+#include "deadlock.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace {
+
+// Recursive freeze test. Boxes already on the recursion stack count as walls, which is
+// what lets two boxes block each other.
+class FreezeCheck {
+public:
+    explicit FreezeCheck(const Board& board)
+        : offGoal(false), board(board), stackSize(0) {}
+
+    bool frozen(int x, int y) {
+        if (stackSize == MAX_STACK) {
+            return false;
+        }
+        // Boxes found frozen below this one assumed it was a wall; drop them if it is not.
+        int savedSize = stackSize;
+        bool savedOffGoal = offGoal;
+        stack[stackSize++] = board.index(x, y);
+        bool result = axisBlocked(x, y, 1, 0) && axisBlocked(x, y, 0, 1);
+        if (!result) {
+            stackSize = savedSize;
+            offGoal = savedOffGoal;
+        } else if (!board.isGoal(x, y)) {
+            offGoal = true;
+        }
+        return result;
+    }
+
+    bool offGoal;
+
+private:
+    static const int MAX_STACK = 32;
+
+    bool solid(int x, int y) const {
+        if (!board.inside(x, y) || board.isWall(x, y)) {
+            return true;
+        }
+        int i = board.index(x, y);
+        for (int k = 0; k < stackSize; k++) {
+            if (stack[k] == i) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool axisBlocked(int x, int y, int dx, int dy) {
+        int ax = x - dx;
+        int ay = y - dy;
+        int bx = x + dx;
+        int by = y + dy;
+        if (solid(ax, ay) || solid(bx, by)) {
+            return true;
+        }
+        if (board.isDead(ax, ay) && board.isDead(bx, by)) {
+            return true;
+        }
+        return (board.hasBox(ax, ay) && frozen(ax, ay)) || (board.hasBox(bx, by) && frozen(bx, by));
+    }
+
+    const Board& board;
+    int stack[MAX_STACK];
+    int stackSize;
+};
+
+bool blockedSquare(const Board& board, int x, int y, bool& offGoal) {
+    for (int dy = 0; dy < 2; dy++) {
+        for (int dx = 0; dx < 2; dx++) {
+            int cx = x + dx;
+            int cy = y + dy;
+            if (!board.inside(cx, cy) || board.isWall(cx, cy)) {
+                continue;
+            }
+            if (!board.hasBox(cx, cy)) {
+                return false;
+            }
+            if (!board.isGoal(cx, cy)) {
+                offGoal = true;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int markDeadSquares(Board& board) {
+    std::vector<uint8_t> live(board.size(), 0);
+    std::vector<Point> queue;
+    for (int y = 0; y < board.height(); y++) {
+        for (int x = 0; x < board.width(); x++) {
+            board.setFlag(x, y, CELL_DEAD, false);
+            if (board.isGoal(x, y) && !board.isWall(x, y)) {
+                live[board.index(x, y)] = 1;
+                queue.push_back({ x, y });
+            }
+        }
+    }
+
+    for (size_t head = 0; head < queue.size(); head++) {
+        Point box = queue[head];
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            int toX = box.x + DIR_DX[d];
+            int toY = box.y + DIR_DY[d];
+            int playerX = toX + DIR_DX[d];
+            int playerY = toY + DIR_DY[d];
+            if (!board.inside(playerX, playerY) || board.isWall(toX, toY) || board.isWall(playerX, playerY)) {
+                continue;
+            }
+            if (!live[board.index(toX, toY)]) {
+                live[board.index(toX, toY)] = 1;
+                queue.push_back({ toX, toY });
+            }
+        }
+    }
+
+    int dead = 0;
+    for (int y = 0; y < board.height(); y++) {
+        for (int x = 0; x < board.width(); x++) {
+            if (!board.isWall(x, y) && !live[board.index(x, y)]) {
+                board.setFlag(x, y, CELL_DEAD, true);
+                dead++;
+            }
+        }
+    }
+    return dead;
+}
+
+int countInteriorCells(const Board& board, int* deadCount) {
+    std::vector<uint8_t> seen(board.size(), 0);
+    std::vector<Point> queue;
+    Point start = board.player();
+    if (!board.inside(start.x, start.y)) {
+        return 0;
+    }
+    seen[board.index(start.x, start.y)] = 1;
+    queue.push_back(start);
+    for (size_t head = 0; head < queue.size(); head++) {
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            int x = queue[head].x + DIR_DX[d];
+            int y = queue[head].y + DIR_DY[d];
+            if (board.inside(x, y) && !board.isWall(x, y) && !seen[board.index(x, y)]) {
+                seen[board.index(x, y)] = 1;
+                queue.push_back({ x, y });
+            }
+        }
+    }
+    if (deadCount) {
+        *deadCount = 0;
+        for (const Point& cell : queue) {
+            if (board.isDead(cell.x, cell.y)) {
+                (*deadCount)++;
+            }
+        }
+    }
+    return int(queue.size());
+}
+
+bool isFreezeDeadlock(const Board& board, int x, int y) {
+    // The four 2x2 squares containing the box: all boxes or walls, with a box off goal.
+    for (int oy = -1; oy <= 0; oy++) {
+        for (int ox = -1; ox <= 0; ox++) {
+            bool offGoal = false;
+            if (blockedSquare(board, x + ox, y + oy, offGoal) && offGoal) {
+                return true;
+            }
+        }
+    }
+
+    FreezeCheck check(board);
+    return check.frozen(x, y) && check.offGoal;
+}
@@ -0,0 +1,24 @@
+#ifndef SOKOBAN_DEADLOCK_H
+#define SOKOBAN_DEADLOCK_H
+
+#include "board.h"
+
+
+// Sets CELL_DEAD on every floor cell from which no box can ever be pushed onto a goal.
+// Live cells are found by pulling a box backwards from each goal: a box can be pulled
+// from a cell to its neighbour when both that neighbour and the cell behind it are not walls.
+// Walls are never marked. Returns the number of dead cells.
+int markDeadSquares(Board& board);
+
+// Floor cells the player could walk to if there were no boxes, the denominator for
+// reporting how much of a level the dead squares rule out. `deadCount` receives how
+// many of those cells are marked dead.
+int countInteriorCells(const Board& board, int* deadCount = nullptr);
+
+// Checks the neighbourhood of a box that was just pushed to (x, y) for boxes that can never
+// move again while one of them is off a goal: a 2x2 block of boxes and walls, or a group of
+// boxes frozen against walls, dead squares and each other. Only boxes connected to the pushed
+// one are examined, so the cost is independent of the board size.
+bool isFreezeDeadlock(const Board& board, int x, int y);
+
+#endif
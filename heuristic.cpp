@@ -0,0 +1,176 @@
+#include "heuristic.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace {
+
+// Distance of a goal a box cannot reach. Small enough that a sum over all boxes cannot
+// overflow, large enough that any matching using it is recognised as impossible.
+const int UNREACHABLE = 1 << 20;
+
+}  // namespace
+
+MatchingHeuristic::MatchingHeuristic(const Board& board, HeuristicKind kind, const PushDistanceTable* pushes, int margin)
+    : heuristicKind(kind), width(board.width()), pushes(pushes) {
+    for (int i = 0; i < board.size(); i++) {
+        if (board.isGoalAt(i)) {
+            goals.push_back(i);
+        }
+    }
+    if (kind == HEURISTIC_PUSHES) {
+        int innerWidth = board.width() - 2 * margin;
+        cellMap.assign(board.size(), -1);
+        for (int y = margin; y < board.height() - margin; y++) {
+            for (int x = margin; x < board.width() - margin; x++) {
+                cellMap[board.index(x, y)] = (y - margin) * innerWidth + (x - margin);
+            }
+        }
+    }
+}
+
+int MatchingHeuristic::distance(int goal, int cell) const {
+    if (heuristicKind == HEURISTIC_MANHATTAN) {
+        return std::abs(cell % width - goals[goal] % width) + std::abs(cell / width - goals[goal] / width);
+    }
+    uint16_t pushCount = cellMap[cell] < 0 ? PUSH_DISTANCE_UNREACHABLE : pushes->distance(goal, cellMap[cell]);
+    return pushCount == PUSH_DISTANCE_UNREACHABLE ? UNREACHABLE : pushCount;
+}
+
+void MatchingHeuristic::fillRow(int row, int cell) {
+    int* out = cost.data() + size_t(row) * m;
+    if (heuristicKind == HEURISTIC_MANHATTAN || cellMap[cell] < 0) {
+        for (int j = 0; j < m; j++) {
+            out[j] = distance(j, cell);
+        }
+        return;
+    }
+    const uint16_t* pushCounts = pushes->row(cellMap[cell]);
+    for (int j = 0; j < m; j++) {
+        out[j] = pushCounts[j] == PUSH_DISTANCE_UNREACHABLE ? UNREACHABLE : pushCounts[j];
+    }
+}
+
+// One phase of the Hungarian algorithm: finds the cheapest augmenting path from the unmatched
+// `row` (1-based) with Dijkstra on reduced costs, then flips it. Needs potentials that are
+// feasible for every row and tight on every matched pair.
+void MatchingHeuristic::augment(int row) {
+    match[0] = row;
+    int j0 = 0;
+    minv.assign(m + 1, INT_MAX);
+    used.assign(m + 1, false);
+    do {
+        used[j0] = true;
+        int i0 = match[j0];
+        int delta = INT_MAX;
+        int j1 = 0;
+        for (int j = 1; j <= m; j++) {
+            if (used[j]) {
+                continue;
+            }
+            int current = cost[size_t(i0 - 1) * m + (j - 1)] - u[i0] - v[j];
+            if (current < minv[j]) {
+                minv[j] = current;
+                way[j] = j0;
+            }
+            if (minv[j] < delta) {
+                delta = minv[j];
+                j1 = j;
+            }
+        }
+        for (int j = 0; j <= m; j++) {
+            if (used[j]) {
+                u[match[j]] += delta;
+                v[j] -= delta;
+            } else {
+                minv[j] -= delta;
+            }
+        }
+        j0 = j1;
+    } while (match[j0] != 0);
+    do {
+        int j1 = way[j0];
+        match[j0] = match[j1];
+        j0 = j1;
+    } while (j0);
+}
+
+int MatchingHeuristic::matchedCost() const {
+    int total = 0;
+    for (int j = 1; j <= m; j++) {
+        if (match[j] != 0) {
+            total += cost[size_t(match[j] - 1) * m + (j - 1)];
+        }
+    }
+    return total >= UNREACHABLE ? HEURISTIC_UNSOLVABLE : total;
+}
+
+int MatchingHeuristic::solveRows(const uint16_t* boxes) {
+    if (n == 0) {
+        return 0;
+    }
+    if (m < n) {
+        return HEURISTIC_UNSOLVABLE;
+    }
+    cost.resize(size_t(n) * m);
+    for (int i = 0; i < n; i++) {
+        fillRow(i, boxes[i]);
+    }
+    u.assign(n + 1, 0);
+    v.assign(m + 1, 0);
+    match.assign(m + 1, 0);
+    way.assign(m + 1, 0);
+    for (int i = 1; i <= n; i++) {
+        augment(i);
+    }
+    return matchedCost();
+}
+
+int MatchingHeuristic::solve(const uint16_t* boxes, int count) {
+    n = count;
+    m = int(goals.size());
+    solvedBoxes.assign(boxes, boxes + count);
+    int bound = solveRows(boxes);
+    if (n == 0 || m < n) {
+        return bound;
+    }
+    solvedU = u;
+    solvedV = v;
+    solvedMatch = match;
+    rowColumn.assign(n + 1, 0);
+    for (int j = 1; j <= m; j++) {
+        rowColumn[match[j]] = j;
+    }
+    return bound;
+}
+
+int MatchingHeuristic::childBound(int row, int cell) {
+    if (n == 0) {
+        return 0;
+    }
+    if (m != n) {
+        // With spare goals the freed goal's potential need not be zero, which the rectangular
+        // problem requires; solve the child on its own. The kept matching is then unused.
+        std::vector<uint16_t> child = solvedBoxes;
+        child[row] = uint16_t(cell);
+        return solveRows(child.data());
+    }
+
+    savedRow.assign(cost.begin() + size_t(row) * m, cost.begin() + size_t(row + 1) * m);
+    fillRow(row, cell);
+    u = solvedU;
+    v = solvedV;
+    match = solvedMatch;
+    int i = row + 1;
+    match[rowColumn[i]] = 0;
+    // Only this row's costs changed; the smallest reduced cost in it becomes zero again, and
+    // every other row keeps feasible, tight potentials.
+    int best = INT_MAX;
+    for (int j = 1; j <= m; j++) {
+        best = std::min(best, cost[size_t(row) * m + (j - 1)] - v[j]);
+    }
+    u[i] = best;
+    augment(i);
+    int bound = matchedCost();
+    std::copy(savedRow.begin(), savedRow.end(), cost.begin() + size_t(row) * m);
+    return bound;
+}
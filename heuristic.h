@@ -0,0 +1,74 @@
+#ifndef SOKOBAN_HEURISTIC_H
+#define SOKOBAN_HEURISTIC_H
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "board.h"
+#include "pushdistance.h"
+
+
+// Returned when the boxes cannot all be matched to goals.
+const int HEURISTIC_UNSOLVABLE = INT_MAX;
+
+
+// HEURISTIC_MANHATTAN matches boxes to goals by Manhattan distance and solves every position
+// from scratch. HEURISTIC_PUSHES uses the pushes a lone box needs to reach each goal (see
+// PushDistanceTable), and derives a child position's bound from its parent's matching.
+enum HeuristicKind { HEURISTIC_MANHATTAN, HEURISTIC_PUSHES };
+
+
+// Lower bound on the pushes left: the cost of a minimum-cost perfect matching of boxes to goals,
+// solved with the Hungarian algorithm. Cells are indices into `board`.
+class MatchingHeuristic {
+public:
+    // HEURISTIC_PUSHES reads its distances from `pushes`, which must outlive the heuristic and
+    // was built for `board` without its outer `margin` rings of cells (the solver surrounds the
+    // level with one ring of walls).
+    MatchingHeuristic(const Board& board, HeuristicKind kind, const PushDistanceTable* pushes = nullptr, int margin = 0);
+
+    HeuristicKind kind() const { return heuristicKind; }
+    const std::vector<int>& goalCells() const { return goals; }
+
+    // Pushes, or Manhattan steps, from `cell` to goal number `goal` with no other box on the
+    // board; a large value if the box can never get there.
+    int distance(int goal, int cell) const;
+
+    // Full O(boxes^2 * goals) solve. The matching and its dual potentials are kept for
+    // childBound().
+    int solve(const uint16_t* boxes, int count);
+
+    // The bound once box `row` of the last solve() has moved to `cell`. With as many goals as
+    // boxes, the box is unmatched, its row potential repaired and a single augmenting path
+    // found, O(boxes * goals); otherwise the child is solved in full. The kept matching is not
+    // changed, so every child of one position can be bounded in turn.
+    int childBound(int row, int cell);
+
+private:
+    void fillRow(int row, int cell);
+    int solveRows(const uint16_t* boxes);
+    void augment(int row);
+    int matchedCost() const;
+
+    HeuristicKind heuristicKind;
+    int width;
+    const PushDistanceTable* pushes;
+    std::vector<int> cellMap;  // cell of `board` to cell of the table, -1 in the margin
+    std::vector<int> goals;
+
+    // Hungarian state, rows are boxes and columns goals, 1-based as in the classic formulation.
+    int n = 0;
+    int m = 0;
+    std::vector<int> cost;  // n x m, 0-based
+    std::vector<int> u, v, match, way, minv;
+    std::vector<bool> used;
+
+    // The last solve(): its boxes, potentials and column owners.
+    std::vector<uint16_t> solvedBoxes;
+    std::vector<int> solvedU, solvedV, solvedMatch;
+    std::vector<int> rowColumn;  // column matched to each row, 1-based
+    std::vector<int> savedRow;
+};
+
+#endif
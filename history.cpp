@@ -0,0 +1,58 @@
+#include "history.h"
+
+void MoveHistory::clear() {
+    entries.clear();
+    cursor = 0;
+}
+
+void MoveHistory::record(int dir, bool pushed) {
+    entries.resize(cursor);
+    entries.push_back(uint8_t(dir) | (pushed ? HISTORY_PUSH : 0));
+    cursor++;
+}
+
+bool MoveHistory::undo(Board& board, int* dir, bool* pushed) {
+    if (!canUndo()) {
+        return false;
+    }
+    uint8_t entry = entries[--cursor];
+    int d = entry & 3;
+    bool push = (entry & HISTORY_PUSH) != 0;
+    board.undoMove(DIR_DX[d], DIR_DY[d], push);
+    if (dir) {
+        *dir = d;
+    }
+    if (pushed) {
+        *pushed = push;
+    }
+    return true;
+}
+
+bool MoveHistory::redo(Board& board, int* dir, bool* pushed) {
+    if (!canRedo()) {
+        return false;
+    }
+    int d = entries[cursor] & 3;
+    bool push = false;
+    if (!board.movePlayer(DIR_DX[d], DIR_DY[d], &push)) {
+        return false;
+    }
+    cursor++;
+    if (dir) {
+        *dir = d;
+    }
+    if (pushed) {
+        *pushed = push;
+    }
+    return true;
+}
+
+std::string MoveHistory::moves() const {
+    std::string text;
+    text.reserve(cursor);
+    for (size_t i = 0; i < cursor; i++) {
+        int d = entries[i] & 3;
+        text += (entries[i] & HISTORY_PUSH) ? DIR_PUSH_CHAR[d] : DIR_MOVE_CHAR[d];
+    }
+    return text;
+}
@@ -0,0 +1,45 @@
+#ifndef SOKOBAN_HISTORY_H
+#define SOKOBAN_HISTORY_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "board.h"
+
+
+// Set in a history entry when the move pushed a box.
+const uint8_t HISTORY_PUSH = 1 << 2;
+
+
+// The moves made since a level was (re)started, one byte each: the direction in the low two
+// bits plus HISTORY_PUSH. Undo and redo apply a single entry to the board, so both are O(1)
+// and never copy it. Entries past the cursor are the redo list until a new move replaces them.
+class MoveHistory {
+public:
+    void clear();
+
+    // Appends a move the caller has already made on its board; Board::movePlayer() does not
+    // record anything itself. The game calls this from SokobanGame::movePlayer().
+    void record(int dir, bool pushed);
+
+    bool canUndo() const { return cursor > 0; }
+    bool canRedo() const { return cursor < entries.size(); }
+
+    // Reverses the last move on `board`. `dir` and `pushed` receive what was undone.
+    bool undo(Board& board, int* dir = nullptr, bool* pushed = nullptr);
+
+    // Makes the next undone move again. Returns false if there is none or it is blocked.
+    bool redo(Board& board, int* dir = nullptr, bool* pushed = nullptr);
+
+    // Moves up to the cursor.
+    int size() const { return int(cursor); }
+
+    // The moves up to the cursor in LURD notation (uppercase letters are pushes).
+    std::string moves() const;
+
+private:
+    std::vector<uint8_t> entries;
+    size_t cursor = 0;
+};
+
+#endif
@@ -0,0 +1,428 @@
+#include "levelpack.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include "deadlock.h"
+
+namespace {
+
+bool isBoardRow(const std::string& line) {
+    bool hasWall = false;
+    for (char c : line) {
+        if (c == '#') {
+            hasWall = true;
+        } else if (!std::strchr("@+$*.-_ ", c)) {
+            return false;
+        }
+    }
+    return hasWall;
+}
+
+std::string trimmed(const std::string& text) {
+    size_t begin = text.find_first_not_of(" \t");
+    if (begin == std::string::npos) {
+        return std::string();
+    }
+    size_t end = text.find_last_not_of(" \t");
+    return text.substr(begin, end - begin + 1);
+}
+
+bool startsWithTitle(const std::string& text) {
+    static const char tag[] = "title:";
+    if (text.size() < sizeof(tag) - 1) {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(tag) - 1; i++) {
+        if (std::tolower(static_cast<unsigned char>(text[i])) != tag[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+LevelPackReader::LevelPackReader(std::istream& in) : in(in) {}
+
+bool LevelPackReader::readLine() {
+    lineOffset = position;
+    if (!std::getline(in, line)) {
+        haveLine = false;
+        return false;
+    }
+    position += line.size() + (in.eof() ? 0 : 1);
+    counters.bytes = position;
+    lineNumber++;
+    size_t end = line.find_last_not_of(" \r");
+    line.resize(end == std::string::npos ? 0 : end + 1);
+    lineIsBoard = isBoardRow(line);
+    haveLine = true;
+    return true;
+}
+
+bool LevelPackReader::next(PackLevel& level) {
+    while (true) {
+        while (!(haveLine && lineIsBoard)) {
+            if (!readLine()) {
+                return false;
+            }
+        }
+        level.offset = lineOffset;
+        int firstLine = lineNumber;
+        rows.clear();
+        while (haveLine && lineIsBoard) {
+            rows.push_back(line);
+            readLine();
+        }
+        level.length = lineOffset - level.offset;
+        level.hash = hashLevelRows(rows);
+
+        // Everything up to the next board belongs to this level; only the title is kept.
+        level.title.clear();
+        bool tagged = false;
+        while (haveLine && !lineIsBoard) {
+            std::string text = trimmed(line);
+            if (startsWithTitle(text)) {
+                level.title = trimmed(text.substr(6));
+                tagged = true;
+            } else if (!tagged && level.title.empty() && !text.empty()) {
+                if (text[0] == ';') {
+                    text = trimmed(text.substr(1));
+                }
+                if (text.find(':') == std::string::npos) {
+                    level.title = text;
+                }
+            }
+            readLine();
+        }
+
+        std::string error;
+        if (parseXsbLevel(rows, level.board, error)) {
+            counters.levels++;
+            return true;
+        }
+        counters.rejected++;
+        std::cerr << "Skipping level at line " << firstLine << ": " << error << std::endl;
+    }
+}
+
+uint64_t hashLevelRows(const std::vector<std::string>& rows) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const std::string& row : rows) {
+        for (char c : row) {
+            hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+        }
+        hash = (hash ^ uint8_t('\n')) * 1099511628211ull;
+    }
+    return hash;
+}
+
+bool parseXsbLevel(const std::vector<std::string>& rows, Board& board, std::string& error) {
+    int height = int(rows.size());
+    int width = 0;
+    for (const std::string& row : rows) {
+        width = std::max(width, int(row.size()));
+    }
+    if (width == 0 || height == 0) {
+        error = "empty level";
+        return false;
+    }
+    if (width > PACK_LEVEL_MAX_SIDE || height > PACK_LEVEL_MAX_SIDE) {
+        error = "larger than " + std::to_string(PACK_LEVEL_MAX_SIDE) + " cells on a side";
+        return false;
+    }
+
+    board = Board(width, height);
+    int players = 0;
+    int boxes = 0;
+    int goals = 0;
+    for (int y = 0; y < height; y++) {
+        const std::string& row = rows[y];
+        for (int x = 0; x < int(row.size()); x++) {
+            char c = row[x];
+            bool goal = c == '.' || c == '*' || c == '+';
+            bool box = c == '$' || c == '*';
+            if (c == '@' || c == '+') {
+                players++;
+                board.setPlayer({ x, y });
+            } else if (c == '#') {
+                board.setWall(x, y, true);
+            } else if (!goal && !box && !std::strchr(" -_", c)) {
+                error = std::string("unexpected character '") + c + "'";
+                return false;
+            }
+            if (goal) {
+                board.setGoal(x, y, true);
+                goals++;
+            }
+            if (box) {
+                board.setBox(x, y, true);
+                boxes++;
+            }
+        }
+    }
+
+    if (players != 1) {
+        error = players == 0 ? "no player" : "more than one player";
+        return false;
+    }
+    if (boxes == 0) {
+        error = "no boxes";
+        return false;
+    }
+    if (boxes != goals) {
+        error = std::to_string(boxes) + " boxes but " + std::to_string(goals) + " goals";
+        return false;
+    }
+
+    // The walls around the player must be closed, or the player could walk off the map.
+    std::vector<uint8_t> seen(board.size(), 0);
+    std::vector<int> queue;
+    Point start = board.player();
+    queue.push_back(board.index(start.x, start.y));
+    seen[queue.back()] = 1;
+    for (size_t head = 0; head < queue.size(); head++) {
+        int x = queue[head] % width;
+        int y = queue[head] / width;
+        if (x == 0 || y == 0 || x == width - 1 || y == height - 1) {
+            error = "not enclosed by walls";
+            return false;
+        }
+        for (int dir = 0; dir < DIRECTION_COUNT; dir++) {
+            int next = queue[head] + board.offset(dir);
+            if (!seen[next] && !board.isWallAt(next)) {
+                seen[next] = 1;
+                queue.push_back(next);
+            }
+        }
+    }
+    return true;
+}
+
+std::string formatXsbLevel(const Board& board) {
+    std::vector<std::string> rows(board.height());
+    Point player = board.player();
+    for (int y = 0; y < board.height(); y++) {
+        std::string& row = rows[y];
+        for (int x = 0; x < board.width(); x++) {
+            bool goal = board.isGoal(x, y);
+            if (board.isWall(x, y)) {
+                row += '#';
+            } else if (board.hasBox(x, y)) {
+                row += goal ? '*' : '$';
+            } else if (player.x == x && player.y == y) {
+                row += goal ? '+' : '@';
+            } else {
+                row += goal ? '.' : ' ';
+            }
+        }
+        size_t end = row.find_last_not_of(' ');
+        row.resize(end == std::string::npos ? 0 : end + 1);
+    }
+
+    // Crop the empty margin: a blank row would end the level for a reader.
+    size_t indent = std::string::npos;
+    int first = -1;
+    int last = -1;
+    for (int y = 0; y < int(rows.size()); y++) {
+        if (!rows[y].empty()) {
+            indent = std::min(indent, rows[y].find_first_not_of(' '));
+            first = first < 0 ? y : first;
+            last = y;
+        }
+    }
+    std::string text;
+    for (int y = first; y >= 0 && y <= last; y++) {
+        if (rows[y].size() > indent) {
+            text.append(rows[y], indent, std::string::npos);
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+bool loadLevelPack(const std::string& path, std::vector<Board>& levels, LevelPackStats* stats,
+                   std::vector<std::string>* titles) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::cerr << "Unable to open level pack " << path << std::endl;
+        return false;
+    }
+
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    LevelPackReader reader(in);
+    PackLevel level;
+    while (reader.next(level)) {
+        markDeadSquares(level.board);
+        levels.push_back(std::move(level.board));
+        if (titles) {
+            titles->push_back(level.title);
+        }
+    }
+    if (stats) {
+        *stats = reader.stats();
+        stats->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    }
+    return true;
+}
+
+namespace {
+
+const char INDEX_MAGIC[8] = { 'S', 'O', 'K', 'I', 'D', 'X', '1', '\0' };
+const uint32_t INDEX_VERSION = 1;
+
+bool packFileInfo(const std::string& path, uint64_t& bytes, int64_t& time) {
+    std::error_code error;
+    bytes = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    time = int64_t(std::filesystem::last_write_time(path, error).time_since_epoch().count());
+    return !error;
+}
+
+}  // namespace
+
+bool IndexedLevelPack::scanPack(const std::string& packPath, std::vector<LevelIndexEntry>& found, LevelPackStats* stats) {
+    std::ifstream in(packPath, std::ios::binary);
+    if (!in) {
+        std::cerr << "Unable to open level pack " << packPath << std::endl;
+        return false;
+    }
+    LevelPackReader reader(in);
+    PackLevel level;
+    while (reader.next(level)) {
+        LevelIndexEntry entry = {};
+        entry.offset = level.offset;
+        entry.hash = level.hash;
+        entry.length = uint32_t(level.length);
+        entry.width = uint16_t(level.board.width());
+        entry.height = uint16_t(level.board.height());
+        entry.boxes = uint16_t(level.board.boxCount());
+        found.push_back(entry);
+    }
+    if (stats) {
+        *stats = reader.stats();
+    }
+    return true;
+}
+
+bool IndexedLevelPack::writeIndex(const std::string& path, const std::vector<LevelIndexEntry>& found, uint64_t packBytes,
+                                  int64_t packTime) {
+    LevelIndexHeader header = {};
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.count = uint32_t(found.size());
+    header.packBytes = packBytes;
+    header.packTime = packTime;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(found.data()), std::streamsize(found.size() * sizeof(LevelIndexEntry)));
+    return bool(out);
+}
+
+bool IndexedLevelPack::buildIndex(const std::string& packPath, LevelPackStats* stats) {
+    uint64_t packBytes = 0;
+    int64_t packTime = 0;
+    std::vector<LevelIndexEntry> found;
+    if (!packFileInfo(packPath, packBytes, packTime) || !scanPack(packPath, found, stats)) {
+        return false;
+    }
+    return writeIndex(indexPath(packPath), found, packBytes, packTime);
+}
+
+bool IndexedLevelPack::mapIndex(const std::string& path, uint64_t packBytes, int64_t packTime) {
+    if (!index.open(path) || index.size() < sizeof(LevelIndexHeader)) {
+        index.close();
+        return false;
+    }
+    const LevelIndexHeader* header = reinterpret_cast<const LevelIndexHeader*>(index.data());
+    bool current = std::memcmp(header->magic, INDEX_MAGIC, sizeof(INDEX_MAGIC)) == 0 && header->version == INDEX_VERSION &&
+                   header->packBytes == packBytes && header->packTime == packTime &&
+                   index.size() == sizeof(LevelIndexHeader) + size_t(header->count) * sizeof(LevelIndexEntry);
+    if (!current) {
+        index.close();
+        return false;
+    }
+    entries = reinterpret_cast<const LevelIndexEntry*>(index.data() + sizeof(LevelIndexHeader));
+    entryCount = int(header->count);
+    return true;
+}
+
+bool IndexedLevelPack::open(const std::string& path, IndexedPackStats* stats) {
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    close();
+    uint64_t packBytes = 0;
+    int64_t packTime = 0;
+    if (!packFileInfo(path, packBytes, packTime) || !pack.open(path)) {
+        std::cerr << "Unable to open level pack " << path << std::endl;
+        return false;
+    }
+
+    bool rebuilt = false;
+    std::string sidecar = indexPath(path);
+    if (!mapIndex(sidecar, packBytes, packTime)) {
+        rebuilt = true;
+        std::vector<LevelIndexEntry> found;
+        if (!scanPack(path, found, nullptr)) {
+            close();
+            return false;
+        }
+        if (!writeIndex(sidecar, found, packBytes, packTime) || !mapIndex(sidecar, packBytes, packTime)) {
+            // Read-only directory: keep the index in memory for this run.
+            std::cerr << "Unable to write level index " << sidecar << ", indexing again next time" << std::endl;
+            ownedEntries.swap(found);
+            entries = ownedEntries.data();
+            entryCount = int(ownedEntries.size());
+        }
+    }
+    if (stats) {
+        stats->rebuilt = rebuilt;
+        stats->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    }
+    return true;
+}
+
+void IndexedLevelPack::close() {
+    pack.close();
+    index.close();
+    ownedEntries.clear();
+    entries = nullptr;
+    entryCount = 0;
+}
+
+bool IndexedLevelPack::load(int i, Board& board) const {
+    const LevelIndexEntry& found = entries[i];
+    if (found.offset + found.length > pack.size()) {
+        std::cerr << "Level " << i + 1 << " lies outside the pack; rebuild its index" << std::endl;
+        return false;
+    }
+    const char* text = reinterpret_cast<const char*>(pack.data()) + found.offset;
+    std::vector<std::string> rows;
+    size_t begin = 0;
+    while (begin < found.length) {
+        const void* newline = std::memchr(text + begin, '\n', found.length - begin);
+        size_t end = newline ? size_t(static_cast<const char*>(newline) - text) : size_t(found.length);
+        std::string row(text + begin, end - begin);
+        size_t last = row.find_last_not_of(" \r");
+        row.resize(last == std::string::npos ? 0 : last + 1);
+        rows.push_back(row);
+        begin = end + 1;
+    }
+
+    std::string error;
+    if (hashLevelRows(rows) != found.hash) {
+        std::cerr << "Level " << i + 1 << " changed since the pack was indexed" << std::endl;
+        return false;
+    }
+    if (!parseXsbLevel(rows, board, error)) {
+        std::cerr << "Level " << i + 1 << ": " << error << std::endl;
+        return false;
+    }
+    markDeadSquares(board);
+    return true;
+}
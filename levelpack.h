@@ -0,0 +1,145 @@
+#ifndef SOKOBAN_LEVELPACK_H
+#define SOKOBAN_LEVELPACK_H
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+#include "board.h"
+#include "mappedfile.h"
+
+
+// Largest level side accepted from a pack; anything bigger is rejected as malformed.
+const int PACK_LEVEL_MAX_SIDE = 128;
+
+
+struct LevelPackStats {
+    int levels = 0;
+    int rejected = 0;        // levels that failed validation and were skipped
+    uint64_t bytes = 0;
+    double milliseconds = 0.0;
+
+    double levelsPerSecond() const { return milliseconds > 0.0 ? levels * 1000.0 / milliseconds : 0.0; }
+    double megabytesPerSecond() const { return milliseconds > 0.0 ? bytes / 1048.576 / milliseconds : 0.0; }
+};
+
+
+struct PackLevel {
+    Board board;
+    std::string title;
+    uint64_t offset = 0;  // byte offset of the level's first row in the pack
+    uint64_t length = 0;  // bytes from the first row to the end of the last one
+    uint64_t hash = 0;    // FNV-1a of the rows, see hashLevelRows()
+};
+
+
+// Reads levels one at a time from a pack in the standard text format: XSB rows
+// ('#' wall, '@' player, '+' player on goal, '$' box, '*' box on goal, '.' goal,
+// ' ', '-' or '_' floor) separated by any non-board line. "Title:" lines and ';' comments
+// after a board name it. Only the rows of the current level are held in memory.
+class LevelPackReader {
+public:
+    explicit LevelPackReader(std::istream& in);
+
+    // Fills `level` with the next valid level. Invalid levels are reported on std::cerr,
+    // counted in stats().rejected and skipped. Returns false at the end of the input.
+    bool next(PackLevel& level);
+
+    const LevelPackStats& stats() const { return counters; }
+
+private:
+    bool readLine();
+
+    std::istream& in;
+    std::string line;
+    bool lineIsBoard = false;
+    bool haveLine = false;
+    uint64_t lineOffset = 0;
+    uint64_t position = 0;
+    int lineNumber = 0;
+    std::vector<std::string> rows;
+    LevelPackStats counters;
+};
+
+
+// FNV-1a over the rows with trailing blanks and '\r' removed, each followed by '\n'.
+uint64_t hashLevelRows(const std::vector<std::string>& rows);
+
+// Builds a board from XSB rows. Returns false and sets `error` when the level has no or
+// several players, no boxes, a box/goal count mismatch, is too large, or lets the player
+// walk off the edge of the map.
+bool parseXsbLevel(const std::vector<std::string>& rows, Board& board, std::string& error);
+
+// The board in XSB notation, one row per line, trailing floor trimmed.
+std::string formatXsbLevel(const Board& board);
+
+// Streams every valid level of the pack at `path` into `levels` with dead squares marked.
+// `titles`, when given, receives one entry per level. Returns false if the file cannot be read.
+bool loadLevelPack(const std::string& path, std::vector<Board>& levels, LevelPackStats* stats = nullptr,
+                   std::vector<std::string>* titles = nullptr);
+
+
+// Sidecar index written next to a pack as "<pack>.idx": a header followed by one fixed-size
+// entry per valid level. Both are read in place from a memory mapping.
+struct LevelIndexHeader {
+    char magic[8];        // "SOKIDX1" and a NUL
+    uint32_t version;
+    uint32_t count;
+    uint64_t packBytes;   // size and modification time of the pack the index was built from;
+    int64_t packTime;     // a mismatch means the index is stale and is rebuilt
+};
+
+struct LevelIndexEntry {
+    uint64_t offset;
+    uint64_t hash;
+    uint32_t length;
+    uint16_t width;
+    uint16_t height;
+    uint16_t boxes;
+    uint16_t reserved[3];
+};
+
+static_assert(sizeof(LevelIndexHeader) == 32, "index header layout is part of the file format");
+static_assert(sizeof(LevelIndexEntry) == 32, "index entry layout is part of the file format");
+
+
+struct IndexedPackStats {
+    bool rebuilt = false;      // the index had to be built by streaming the whole pack
+    double milliseconds = 0.0; // time spent in open()
+};
+
+
+// A pack opened through its sidecar index: open() maps the pack and the index and touches
+// neither beyond the header, so startup does not depend on the number of levels. Levels are
+// parsed on demand by load(). A missing or stale index is rebuilt once by streaming the pack.
+class IndexedLevelPack {
+public:
+    bool open(const std::string& path, IndexedPackStats* stats = nullptr);
+    void close();
+
+    int count() const { return entryCount; }
+    const LevelIndexEntry& entry(int i) const { return entries[i]; }
+
+    // Parses level `i` into `board` with dead squares marked. Returns false if the pack
+    // bytes no longer match the hash recorded in the index.
+    bool load(int i, Board& board) const;
+
+    static std::string indexPath(const std::string& packPath) { return packPath + ".idx"; }
+
+    // Streams the pack at `packPath` and writes its index. Returns false if either file
+    // cannot be read or written.
+    static bool buildIndex(const std::string& packPath, LevelPackStats* stats = nullptr);
+
+private:
+    static bool scanPack(const std::string& packPath, std::vector<LevelIndexEntry>& found, LevelPackStats* stats);
+    static bool writeIndex(const std::string& path, const std::vector<LevelIndexEntry>& found, uint64_t packBytes, int64_t packTime);
+    bool mapIndex(const std::string& path, uint64_t packBytes, int64_t packTime);
+
+    MappedFile pack;
+    MappedFile index;
+    std::vector<LevelIndexEntry> ownedEntries;  // used when the index could not be written
+    const LevelIndexEntry* entries = nullptr;
+    int entryCount = 0;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "levels.h"
+#include "deadlock.h"
+
+static const std::vector<std::string> levelStrings[BUILTIN_LEVEL_COUNT] = {
+{
+    // Level 1
+    ".......................",
+    ".......................",
+    ".......................",
+    ".......................",
+    "#############..........",
+    "#...........#..........",
+    "#..$@$$######..........",
+    "#...........#..........",
+    "#***#.......#..........",
+    "#############..........",
+    ".......................",
+    ".......................",
+    ".......................",
+    "......................."
+},
+{
+    // Level 2
+    "############...........",
+    "#**..#.....###.........",
+    "#**..#.$..$..#.........",
+    "#**..#$####..#.........",
+    "#**....@.##..#.........",
+    "#**..#.#..$.##.........",
+    "######.##$.$.#.........",
+    "..#.$..$.$.$.#.........",
+    "..#....#.....#.........",
+    "..############.........",
+    ".......................",
+    ".......................",
+    ".......................",
+    "......................."
+},
+{
+    // Level 3
+    "    #####              ",
+    "    #   #              ",
+    "    #$  #              ",
+    "  ###  $###            ",
+    "  #  $  $ #            ",
+    "### # ### #      ######",
+    "#   # ### ########  **#",
+    "# $  $              **#",
+    "##### #### #@#####  **#",
+    "    #      ###   ######",
+    "    ########           ",
+    ".......................",
+    ".......................",
+    "......................."
+},
+{
+    // Level 4
+    "      ####             ",
+    "####### @#             ",
+    "#     $  #             ",
+    "#   $## $#             ",
+    "##$#***# #             ",
+    " # $***  #             ",
+    " # #* *# ##            ",
+    " #   # #$ #            ",
+    " #$  $    #            ",
+    " #  #######            ",
+    " ####                  ",
+    ".......................",
+    ".......................",
+    "......................."
+},
+{
+    // Level 5
+    "        ########       ",
+    "    #####  #  ####     ",
+    "    #   #   $    #     ",
+    " #### #$$ ## ##  #     ",
+    "##      # #  ## ###    ",
+    "#  ### $#$  $  $  #    ",
+    "#***    # ##  #   #    ",
+    "#***#    @ # ### ##    ",
+    "#***#  ###  $  $  #    ",
+    "######## ##   #   #    ",
+    "          #########    ",
+    ".......................",
+    ".......................",
+    "......................."
+},
+{
+    // Level 6
+    "         ####          ",
+    " #########  ##         ",
+    "##  $      $ #####     ",
+    "#   ## ##   ##***#     ",
+    "# #$$ $ $$#$##***#     ",
+    "# #    @  #   ***#     ",
+    "#  $# ###$$   ***#     ",
+    "# $  $$  $ ##****#     ",
+    "###$       #######     ",
+    "  #  #######           ",
+    "  ####                 ",
+    ".......................",
+    ".......................",
+    "......................."
+},
+{
+    // Level 7
+    "######  ###            ",
+    "#**  # ##@##           ",
+    "#**  ###   #           ",
+    "#**     $$ #           ",
+    "#**  # # $ #           ",
+    "#**### # $ #           ",
+    "#### $ #$  #           ",
+    "   #  $# $ #           ",
+    "   # $  $  #           ",
+    "   #  ##   #           ",
+    "   #########           ",
+    ".......................",
+    ".......................",
+    "......................."
+},
+{
+    // Level 8
+    "                #####  ",
+    "       ###### ###   ####",
+    "   #####    ### $ $  $ #",
+    "####  ## #$ $    $ #   #",
+    "#****   $$ $ $  $   #$##",
+    "#** # ## #   ###$## #  #",
+    "#****    # ###    #    #",
+    "#****    # ##  $  ###$ #",
+    "#**######  $  #  #### ##",
+    "####    #   ###    @  # ",
+    "        ############### ",
+    "........................",
+    "........................",
+    "........................"
+}
+};
+
+Board parseBuiltinLevel(const std::vector<std::string>& rows, int width, int height) {
+    Board board(width, height);
+    for (int y = 0; y < height && y < int(rows.size()); y++) {
+        const std::string& row = rows[y];
+        for (int x = 0; x < width && x < int(row.size()); x++) {
+            switch (row[x]) {
+                case '#':
+                    board.setWall(x, y, true);
+                    break;
+                case '@':
+                    board.setPlayer({ x, y });
+                    break;
+                case '$':
+                    board.setBox(x, y, true);
+                    break;
+                case '*':
+                    board.setGoal(x, y, true);
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+    return board;
+}
+
+const std::vector<std::string>& builtinLevelRows(int index) {
+    return levelStrings[index];
+}
+
+std::vector<Board> loadBuiltinLevels() {
+    std::vector<Board> levels;
+    for (const auto& levelString : levelStrings) {
+        Board board = parseBuiltinLevel(levelString, BUILTIN_LEVEL_WIDTH, BUILTIN_LEVEL_HEIGHT);
+        markDeadSquares(board);
+        levels.push_back(board);
+    }
+    return levels;
+}
@@ -0,0 +1,23 @@
+#ifndef SOKOBAN_LEVELS_H
+#define SOKOBAN_LEVELS_H
+
+#include <string>
+#include <vector>
+#include "board.h"
+
+
+const int BUILTIN_LEVEL_COUNT = 8;
+const int BUILTIN_LEVEL_WIDTH = 24;
+const int BUILTIN_LEVEL_HEIGHT = 14;
+
+
+// The rows of built-in level `index` (0-based), as parseBuiltinLevel() takes them.
+const std::vector<std::string>& builtinLevelRows(int index);
+
+// Built-in level rows use '#' wall, '@' player, '$' box, '*' storage and '.' or ' ' floor.
+Board parseBuiltinLevel(const std::vector<std::string>& rows, int width, int height);
+
+// All built-in levels with their dead squares already marked.
+std::vector<Board> loadBuiltinLevels();
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef SOKOBAN_MAILBOX_H
+#define SOKOBAN_MAILBOX_H
+
+#include <atomic>
+
+
+// Link field for messages sent through a Mailbox; a message type derives from it.
+struct MailboxNode {
+    std::atomic<MailboxNode*> next{ nullptr };
+};
+
+
+// Lock-free multi-producer, single-consumer queue of messages (Vyukov's intrusive MPSC queue).
+// Any thread may send(); only the owning thread may receive(). Sending is one atomic exchange
+// and never waits. The mailbox does not own its messages: the receiver deletes them, and the
+// caller must drain the mailbox before destroying it.
+template <typename Message>
+class Mailbox {
+public:
+    Mailbox() : head(&stub), tail(&stub) {}
+
+    Mailbox(const Mailbox&) = delete;
+    Mailbox& operator=(const Mailbox&) = delete;
+
+    void send(Message* message) { push(message); }
+
+    // The oldest message, or nullptr if there is none. May also return nullptr for a moment
+    // while a send() is halfway done; that message is returned by a later call.
+    Message* receive() {
+        MailboxNode* last = tail;
+        MailboxNode* next = last->next.load(std::memory_order_acquire);
+        if (last == &stub) {
+            if (next == nullptr) {
+                return nullptr;
+            }
+            tail = next;
+            last = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next != nullptr) {
+            tail = next;
+            return static_cast<Message*>(last);
+        }
+        if (last != head.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        push(&stub);
+        next = last->next.load(std::memory_order_acquire);
+        if (next != nullptr) {
+            tail = next;
+            return static_cast<Message*>(last);
+        }
+        return nullptr;
+    }
+
+private:
+    void push(MailboxNode* node) {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        MailboxNode* previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Producers touch only `head`, the consumer mostly `tail`; keep them on separate cache lines.
+    alignas(64) std::atomic<MailboxNode*> head;
+    alignas(64) MailboxNode* tail;
+    MailboxNode stub;
+};
+
+#endif
@@ -3,7 +3,7 @@
 #undef main
 
 SokobanGame::SokobanGame()
-    : window(nullptr), renderer(nullptr), running(false), currentLevelIndex(0), currentState(MENU) {}
+    : window(nullptr), renderer(nullptr), running(false), currentLevelIndex(0), currentState(MENU), backgroundMusic(nullptr) {}
 
 SokobanGame::~SokobanGame() {
     cleanup();
@@ -27,12 +27,16 @@ bool SokobanGame::initialize() {
         std::cerr << "Window could not be created! SDL_Error: " << SDL_GetError() << std::endl;
         return false;
     }
-    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
     if (!renderer) {
         std::cerr << "Renderer could not be created! SDL_Error: " << SDL_GetError() << std::endl;
         return false;
     }
 
+    if (!loadFonts()) {
+        return false;
+    }
+
     loadLevels();
     loadTextures();
     loadMusic();  // Load the background music
@@ -48,9 +52,26 @@ SDL_Texture* SokobanGame::loadTexture(const std::string& path, SDL_Renderer* ren
         return nullptr;
     }
     SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    if (texture) {
+        assetStats.uploadBytes += Uint64(surface->pitch) * surface->h;
+    }
     SDL_FreeSurface(surface);
     return texture;
 }
+
+SDL_Texture* SokobanGame::getTexture(const std::string& path) {
+    auto it = textureAssets.find(path);
+    if (it != textureAssets.end()) {
+        assetStats.hits++;
+        return it->second;
+    }
+    // Failed loads are cached too, so a missing file is only reported once.
+    assetStats.misses++;
+    SDL_Texture* texture = loadTexture(path, renderer);
+    textureAssets[path] = texture;
+    return texture;
+}
+
 void SokobanGame::loadMusic() {
     backgroundMusic = Mix_LoadMUS("bgmusic.mp3");
     if (!backgroundMusic) {
@@ -61,204 +82,188 @@ void SokobanGame::loadMusic() {
 }
 
 void SokobanGame::loadTextures() {
-    textures[EMPTY] = loadTexture("images/empty.bmp", renderer);
-    textures[WALL] = loadTexture("images/wall.bmp", renderer);
-    textures[BOX] = loadTexture("images/box.bmp", renderer);
-    textures[PLAYER] = loadTexture("images/player.bmp", renderer);
-    textures[STORAGE] = loadTexture("images/storage.bmp", renderer);
-    textures[BOX_ON_STORAGE] = loadTexture("images/box.bmp", renderer);
-    textures[PLAYER_ON_STORAGE] = loadTexture("images/playeronstor.bmp", renderer);
+    buildTileAtlas();
+
+    backgrounds[MENU] = getTexture("images/bg.bmp");
+    backgrounds[LEVELS] = getTexture("images/bglevel.bmp");
 }
 
 
-void SokobanGame::loadLevels() {
-    std::vector<std::string> levelStrings[8] = {
-     {
-    // Level 1
-    ".......................",
-    ".......................",
-    ".......................",
-    ".......................",
-    "#############..........",
-    "#...........#..........",
-    "#..$@$$######..........",
-    "#...........#..........",
-    "#***#.......#..........",
-    "#############..........",
-    ".......................",
-    ".......................",
-    ".......................",
-    "......................."
-},
-{
-    // Level 2
-    "############...........",
-    "#**..#.....###.........",
-    "#**..#.$..$..#.........",
-    "#**..#$####..#.........",
-    "#**....@.##..#.........",
-    "#**..#.#..$.##.........",
-    "######.##$.$.#.........",
-    "..#.$..$.$.$.#.........",
-    "..#....#.....#.........",
-    "..############.........",
-    ".......................",
-    ".......................",
-    ".......................",
-    "......................."
-},
-{
-    // Level 3
-    "    #####              ",
-    "    #   #              ",
-    "    #$  #              ",
-    "  ###  $###            ",
-    "  #  $  $ #            ",
-    "### # ### #      ######",
-    "#   # ### ########  **#",
-    "# $  $              **#",
-    "##### #### #@#####  **#",
-    "    #      ###   ######",
-    "    ########           ",
-    ".......................",
-    ".......................",
-    "......................."
-},
-{
-    // Level 4
-    "      ####             ",
-    "####### @#             ",
-    "#     $  #             ",
-    "#   $## $#             ",
-    "##$#***# #             ",
-    " # $***  #             ",
-    " # #* *# ##            ",
-    " #   # #$ #            ",
-    " #$  $    #            ",
-    " #  #######            ",
-    " ####                  ",
-    ".......................",
-    ".......................",
-    "......................."
-},
-{
-    // Level 5
-    "        ########       ",
-    "    #####  #  ####     ",
-    "    #   #   $    #     ",
-    " #### #$$ ## ##  #     ",
-    "##      # #  ## ###    ",
-    "#  ### $#$  $  $  #    ",
-    "#***    # ##  #   #    ",
-    "#***#    @ # ### ##    ",
-    "#***#  ###  $  $  #    ",
-    "######## ##   #   #    ",
-    "          #########    ",
-    ".......................",
-    ".......................",
-    "......................."
-},
-{
-    // Level 6
-    "         ####          ",
-    " #########  ##         ",
-    "##  $      $ #####     ",
-    "#   ## ##   ##***#     ",
-    "# #$$ $ $$#$##***#     ",
-    "# #    @  #   ***#     ",
-    "#  $# ###$$   ***#     ",
-    "# $  $$  $ ##****#     ",
-    "###$       #######     ",
-    "  #  #######           ",
-    "  ####                 ",
-    ".......................",
-    ".......................",
-    "......................."
-},
-{
-    // Level 7
-    "######  ###            ",
-    "#**  # ##@##           ",
-    "#**  ###   #           ",
-    "#**     $$ #           ",
-    "#**  # # $ #           ",
-    "#**### # $ #           ",
-    "#### $ #$  #           ",
-    "   #  $# $ #           ",
-    "   # $  $  #           ",
-    "   #  ##   #           ",
-    "   #########           ",
-    ".......................",
-    ".......................",
-    "......................."
-},
-{
-    // Level 8
-    "                #####  ",
-    "       ###### ###   ####",
-    "   #####    ### $ $  $ #",
-    "####  ## #$ $    $ #   #",
-    "#****   $$ $ $  $   #$##",
-    "#** # ## #   ###$## #  #",
-    "#****    # ###    #    #",
-    "#****    # ##  $  ###$ #",
-    "#**######  $  #  #### ##",
-    "####    #   ###    @  # ",
-    "        ############### ",
-    "........................",
-    "........................",
-    "........................"
-}
+void SokobanGame::buildTileAtlas() {
+    static const std::pair<TileType, const char*> sprites[] = {
+        { EMPTY, "images/empty.bmp" },
+        { WALL, "images/wall.bmp" },
+        { BOX, "images/box.bmp" },
+        { PLAYER, "images/player.bmp" },
+        { STORAGE, "images/storage.bmp" },
+        { BOX_ON_STORAGE, "images/box.bmp" },
+        { PLAYER_ON_STORAGE, "images/playeronstor.bmp" },
     };
+    const int spriteCount = int(sizeof(sprites) / sizeof(sprites[0]));
 
+    SDL_Surface* atlas = SDL_CreateRGBSurfaceWithFormat(0, spriteCount * TILE_SIZE, TILE_SIZE, 32, SDL_PIXELFORMAT_RGBA8888);
+    if (!atlas) {
+        std::cerr << "Unable to create tile atlas! SDL Error: " << SDL_GetError() << std::endl;
+        return;
+    }
 
+    // Sprites shared by several tile types (box.bmp) are packed once; failed loads are
+    // remembered with an empty rect so they are reported once.
+    std::map<std::string, SDL_Rect> packed;
+    int slots = 0;
+    for (const auto& sprite : sprites) {
+        auto it = packed.find(sprite.second);
+        if (it == packed.end()) {
+            assetStats.misses++;
+            SDL_Rect slot = { 0, 0, 0, 0 };
+            SDL_Surface* surface = SDL_LoadBMP(sprite.second);
+            SDL_Surface* converted = surface ? SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_RGBA8888, 0) : nullptr;
+            if (converted) {
+                slot = { slots * TILE_SIZE, 0, TILE_SIZE, TILE_SIZE };
+                SDL_SetSurfaceBlendMode(converted, SDL_BLENDMODE_NONE);
+                SDL_BlitScaled(converted, nullptr, atlas, &slot);
+                SDL_FreeSurface(converted);
+                slots++;
+            } else {
+                std::cerr << "Unable to load image " << sprite.second << "! SDL Error: " << SDL_GetError() << std::endl;
+            }
+            if (surface) {
+                SDL_FreeSurface(surface);
+            }
+            it = packed.emplace(sprite.second, slot).first;
+        } else {
+            assetStats.hits++;
+        }
+        if (it->second.w > 0) {
+            tileRects[sprite.first] = it->second;
+        }
+    }
 
-    for (const auto& levelString : levelStrings) {
-        std::vector<std::vector<Tile>> level;
-        for (int y = 0; y < 14; y++) {
-            std::vector<Tile> row;
-            for (int x = 0; x < 24; x++) {
-                Tile tile;
-                tile.position = { x, y };
-                switch (levelString[y][x]) {
-                    case '#':
-                        tile.type = WALL;
-                        break;
-                    case '@':
-                        tile.type = PLAYER;
-                        playerPosition = tile.position;
-                        break;
-                    case '$':
-                        tile.type = BOX;
-                        break;
-                    case '*':
-                        tile.type = STORAGE;
-                        break;
-                    case '.':
-                        tile.type = EMPTY;
-                        break;
-                    default:
-                        tile.type = EMPTY;
-                        break;
-                }
-                row.push_back(tile);
+    tileAtlas = SDL_CreateTextureFromSurface(renderer, atlas);
+    if (tileAtlas) {
+        assetStats.uploadBytes += Uint64(atlas->pitch) * atlas->h;
+        atlasWidth = atlas->w;
+    } else {
+        std::cerr << "Unable to upload tile atlas! SDL Error: " << SDL_GetError() << std::endl;
+    }
+    SDL_FreeSurface(atlas);
+}
+
+
+void SokobanGame::loadLevels() {
+    levels.clear();
+    levelSource = SOURCE_BUILTIN;
+    levelStartIndex = -1;
+    if (!levelPackPath.empty()) {
+        std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+        bool rebuilt = false;
+        if (BinaryLevelPack::isBinaryPackPath(levelPackPath)) {
+            if (binaryPack.open(levelPackPath) && binaryPack.count() > 0) {
+                levelSource = SOURCE_BINARY_PACK;
             }
-            level.push_back(row);
+        } else {
+            IndexedPackStats stats;
+            if (pack.open(levelPackPath, &stats) && pack.count() > 0) {
+                levelSource = SOURCE_TEXT_PACK;
+                rebuilt = stats.rebuilt;
+            }
+        }
+        if (levelSource == SOURCE_BUILTIN) {
+            std::cerr << "No playable levels in " << levelPackPath << ", using the built-in levels" << std::endl;
+        } else {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+            std::cout << "Opened " << levelPackPath << ": " << levelCount() << " levels in " << ms << " ms"
+                      << (rebuilt ? " (index rebuilt)" : "") << std::endl;
         }
-        levels.push_back(level);
+    }
+    if (levelSource == SOURCE_BUILTIN) {
+        levels = loadBuiltinLevels();
     }
 }
 
+int SokobanGame::levelCount() const {
+    switch (levelSource) {
+        case SOURCE_TEXT_PACK:
+            return pack.count();
+        case SOURCE_BINARY_PACK:
+            return binaryPack.count();
+        default:
+            return int(levels.size());
+    }
+}
+
+bool SokobanGame::fetchLevel(int index, Board& board) const {
+    switch (levelSource) {
+        case SOURCE_TEXT_PACK:
+            return pack.load(index, board);
+        case SOURCE_BINARY_PACK:
+            return binaryPack.load(index, board);
+        default:
+            board = levels[index];
+            return true;
+    }
+}
+
+std::string SokobanGame::levelSummary(int index) const {
+    int width = 0, height = 0, boxes = 0;
+    if (levelSource == SOURCE_TEXT_PACK) {
+        const LevelIndexEntry& entry = pack.entry(index);
+        width = entry.width;
+        height = entry.height;
+        boxes = entry.boxes;
+    } else if (levelSource == SOURCE_BINARY_PACK) {
+        binaryPack.info(index, width, height, boxes);
+    } else {
+        width = levels[index].width();
+        height = levels[index].height();
+        boxes = levels[index].boxCount();
+    }
+    return "Level " + std::to_string(index + 1) + "   " + std::to_string(width) + "x" + std::to_string(height) + ", " +
+           std::to_string(boxes) + " boxes";
+}
+
 
 
 
 void SokobanGame::run() {
     running = true;
     while (running) {
+        // Block until input arrives while the screen is static; while animating, poll and let
+        // vsync in SDL_RenderPresent pace the loop.
+        SDL_Event event;
+        if (SDL_WaitEventTimeout(&event, animating ? 0 : int(IDLE_WAIT_MS))) {
+            handleEvent(event);
+        }
         processInput();
+
+        Uint64 frameStart = SDL_GetPerformanceCounter();
         update();
+        if (animating) {
+            frameDirty = true;
+        }
+        bool presented = frameDirty;
         render();
-        SDL_Delay(16); 
+        if (!presented) {
+            continue;
+        }
+        double frameMs = double(SDL_GetPerformanceCounter() - frameStart) * 1000.0 / double(SDL_GetPerformanceFrequency());
+        frameTimes.add(frameMs);
+        if (pendingInputTicks != 0) {
+            inputLatency.add(double(SDL_GetTicks() - pendingInputTicks));
+            pendingInputTicks = 0;
+        }
+    }
+}
+
+
+void SokobanGame::setAnimating(bool on) {
+    animating = on;
+    if (vsyncOn != on && renderer && SDL_RenderSetVSync(renderer, on ? 1 : 0) == 0) {
+        vsyncOn = on;
+    }
+    if (on && !vsyncOn) {
+        // No vsync available: cap the animation at roughly 60 frames per second instead.
+        SDL_Delay(16);
     }
 }
 
@@ -266,17 +271,55 @@ void SokobanGame::run() {
 
 
 void SokobanGame::cleanup() {
+    saveReplay();
     if (backgroundMusic) {
         Mix_FreeMusic(backgroundMusic);
+        backgroundMusic = nullptr;
+    }
+    clearTextCache();
+    if (boardLayer) {
+        SDL_DestroyTexture(boardLayer);
+        boardLayer = nullptr;
+    }
+    if (tileAtlas) {
+        SDL_DestroyTexture(tileAtlas);
+        tileAtlas = nullptr;
+    }
+    tileRects.clear();
+    if (frameStats.framesRendered + frameStats.framesSkipped > 0) {
+        std::cout << "Frames: " << frameStats.framesRendered << " rendered, " << frameStats.framesSkipped
+                  << " skipped, " << frameStats.lastDrawCalls << " draw calls in the last one" << std::endl;
+    }
+    if (frameTimes.samples > 0) {
+        std::cout << "Frame time: p50 <= " << frameTimes.percentile(50) << " ms, p99 <= " << frameTimes.percentile(99)
+                  << " ms, max " << frameTimes.maxMs << " ms" << std::endl;
+    }
+    if (inputLatency.samples > 0) {
+        std::cout << "Input latency: p50 <= " << inputLatency.percentile(50) << " ms, p99 <= " << inputLatency.percentile(99)
+                  << " ms, max " << inputLatency.maxMs << " ms over " << inputLatency.samples << " inputs" << std::endl;
+    }
+    for (auto& pair : fonts) {
+        TTF_CloseFont(pair.second);
+    }
+    fonts.clear();
+    for (auto& pair : textureAssets) {
+        if (pair.second) {
+            SDL_DestroyTexture(pair.second);
+        }
+    }
+    if (!textureAssets.empty()) {
+        std::cout << "Texture assets: " << assetStats.hits << " hits, " << assetStats.misses << " misses, "
+                  << assetStats.uploadBytes << " bytes uploaded" << std::endl;
     }
+    textureAssets.clear();
+    backgrounds.clear();
     if (renderer) {
         SDL_DestroyRenderer(renderer);
+        renderer = nullptr;
     }
     if (window) {
         SDL_DestroyWindow(window);
-    }
-    for (auto& pair : textures) {
-        SDL_DestroyTexture(pair.second);
+        window = nullptr;
     }
     Mix_Quit();
     TTF_Quit();
@@ -286,33 +329,127 @@ void SokobanGame::cleanup() {
 
 
 
-void SokobanGame::renderMenu() {
- 
-    SDL_Texture* backgroundTexture = loadTexture("images/bg.bmp", renderer);
-    if (!backgroundTexture) {
-        std::cerr << "Failed to load background image!" << std::endl;
+void SokobanGame::drawTexture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst) {
+    if (texture) {
+        SDL_RenderCopy(renderer, texture, src, dst);
+        drawCalls++;
+    }
+}
+
+void SokobanGame::queueSprite(TileType type, int x, int y) {
+    auto it = tileRects.find(type);
+    if (it == tileRects.end()) {
         return;
     }
-    SDL_RenderCopy(renderer, backgroundTexture, nullptr, nullptr);
+    const SDL_Rect& src = it->second;
+    float u0 = float(src.x) / float(atlasWidth);
+    float u1 = float(src.x + src.w) / float(atlasWidth);
+    float left = float(x * TILE_SIZE);
+    float top = float(y * TILE_SIZE);
+    float right = left + TILE_SIZE;
+    float bottom = top + TILE_SIZE;
+    SDL_Color white = { 255, 255, 255, 255 };
 
-    SDL_DestroyTexture(backgroundTexture);
+    int first = int(batchVertices.size());
+    batchVertices.push_back({ { left, top }, white, { u0, 0.0f } });
+    batchVertices.push_back({ { right, top }, white, { u1, 0.0f } });
+    batchVertices.push_back({ { right, bottom }, white, { u1, 1.0f } });
+    batchVertices.push_back({ { left, bottom }, white, { u0, 1.0f } });
+    const int corners[6] = { 0, 1, 2, 0, 2, 3 };
+    for (int corner : corners) {
+        batchIndices.push_back(first + corner);
+    }
+}
 
+void SokobanGame::queueBoardCell(int x, int y) {
+    TileType layers[3];
+    int count = level.cellSprites(x, y, layers);
+    for (int i = 0; i < count; i++) {
+        queueSprite(layers[i], x, y);
+    }
 }
 
+void SokobanGame::flushSprites() {
+    if (!batchIndices.empty() && tileAtlas) {
+        SDL_RenderGeometry(renderer, tileAtlas, batchVertices.data(), int(batchVertices.size()),
+                           batchIndices.data(), int(batchIndices.size()));
+        drawCalls++;
+    }
+    batchVertices.clear();
+    batchIndices.clear();
+}
 
+void SokobanGame::buildBoardLayers() {
+    if (!renderer) {
+        return;
+    }
+    int width = level.width() * TILE_SIZE;
+    int height = level.height() * TILE_SIZE;
+    int layerWidth = 0;
+    int layerHeight = 0;
+    if (boardLayer) {
+        SDL_QueryTexture(boardLayer, nullptr, nullptr, &layerWidth, &layerHeight);
+    }
+    if (layerWidth != width || layerHeight != height) {
+        if (boardLayer) {
+            SDL_DestroyTexture(boardLayer);
+        }
+        boardLayer = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+        if (!boardLayer) {
+            std::cerr << "Unable to create board layer! SDL Error: " << SDL_GetError() << std::endl;
+            return;
+        }
+    }
 
+    SDL_SetRenderTarget(renderer, boardLayer);
+    for (int y = 0; y < level.height(); ++y) {
+        for (int x = 0; x < level.width(); ++x) {
+            queueBoardCell(x, y);
+        }
+    }
+    flushSprites();
+    SDL_SetRenderTarget(renderer, nullptr);
+    dirtyCells.clear();
+    frameDirty = true;
+}
 
+void SokobanGame::flushDirtyCells() {
+    if (dirtyCells.empty() || !boardLayer) {
+        return;
+    }
+    SDL_SetRenderTarget(renderer, boardLayer);
+    for (const Point& cell : dirtyCells) {
+        queueBoardCell(cell.x, cell.y);
+    }
+    flushSprites();
+    SDL_SetRenderTarget(renderer, nullptr);
+    dirtyCells.clear();
+}
+
+void SokobanGame::markCellDirty(Point cell) {
+    dirtyCells.push_back(cell);
+    frameDirty = true;
+}
+
+void SokobanGame::renderMenu() {
+    drawTexture(backgrounds[MENU], nullptr, nullptr);
+}
 
 
 void SokobanGame::renderLevelsMenu() {
-     SDL_Texture* backgroundTexture = loadTexture("images/bglevel.bmp", renderer);
-    if (!backgroundTexture) {
-        std::cerr << "Failed to load background image!" << std::endl;
-        return;
-    }
-    SDL_RenderCopy(renderer, backgroundTexture, nullptr, nullptr);
+    drawTexture(backgrounds[LEVELS], nullptr, nullptr);
 
-    SDL_DestroyTexture(backgroundTexture);
+    // Only the visible page is described; with a pack this reads the index, not the levels.
+    SDL_Color white = { 255, 255, 255, 255 };
+    int first = levelsPage * LEVELS_PER_PAGE;
+    int last = std::min(levelCount(), first + LEVELS_PER_PAGE);
+    renderText("Levels " + std::to_string(first + 1) + "-" + std::to_string(last) + " of " + std::to_string(levelCount()),
+               LEVELS_MENU_X, 60, white, LEVELS_MENU_FONT_SIZE);
+    for (int i = first; i < last; i++) {
+        renderText(std::to_string(i - first + 1) + ".  " + levelSummary(i), LEVELS_MENU_X, 130 + (i - first) * 55, white,
+                   LEVELS_MENU_FONT_SIZE);
+    }
+    renderText("Left/Right - Page   PgUp/PgDn - 10 Pages   1-9 - Play", LEVELS_MENU_X, 650, white, LEVELS_MENU_FONT_SIZE);
 }
 
 
@@ -321,141 +458,227 @@ void SokobanGame::renderLevelsMenu() {
 void SokobanGame::processInput() {
     SDL_Event event;
     while (SDL_PollEvent(&event) != 0) {
-        if (event.type == SDL_QUIT) {
-            running = false;
+        handleEvent(event);
+    }
+}
+
+void SokobanGame::handleEvent(const SDL_Event& event) {
+    if (event.type == SDL_QUIT) {
+        running = false;
+    }
+    if (event.type == SDL_WINDOWEVENT) {
+        frameDirty = true;
+    }
+    if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+        buildBoardLayers();
+    }
+    if (event.type == SDL_MOUSEBUTTONDOWN && event.button.button == SDL_BUTTON_LEFT && currentState == PLAYING &&
+        bannerText.empty()) {
+        // Click to walk: the player goes to the clicked cell if it can get there without pushing.
+        SDL_Rect source;
+        SDL_Rect target;
+        boardPlacement(source, target);
+        if (event.button.x < target.x + target.w && event.button.y < target.y + target.h) {
+            frameDirty = true;
+            if (pendingInputTicks == 0) {
+                pendingInputTicks = event.button.timestamp;
+            }
+            int pixelX = source.x + (event.button.x - target.x) * source.w / target.w;
+            int pixelY = source.y + (event.button.y - target.y) * source.h / target.h;
+            walkTo({ pixelX / TILE_SIZE, pixelY / TILE_SIZE });
         }
-        if (event.type == SDL_KEYDOWN) {
-            switch (event.key.keysym.sym) {
-                case SDLK_ESCAPE:
-                    running = false;
-                    break;
-                case SDLK_RETURN:
-                    if (currentState == MENU) {
-                        currentState = PLAYING;
-                        resetGame(currentLevelIndex);
-                    }
-                    break;
-                case SDLK_1: 
-                    if (currentState == MENU) {
-                        currentState = PLAYING;
-                        currentLevelIndex = 0; 
-                        resetGame(currentLevelIndex);
-                    } else if (currentState == LEVELS) {
-                        currentState = PLAYING;
-                        currentLevelIndex = 0; 
-                        resetGame(currentLevelIndex);
-                    }
-                    break;
-                case SDLK_2:
-                    if (currentState == MENU) {
-                        currentState = LEVELS;
-                    } else if (currentState == LEVELS) {
+    }
+    if (event.type == SDL_KEYDOWN && !bannerText.empty() && event.key.keysym.sym != SDLK_ESCAPE) {
+        return;  // the level is already solved; ignore keys until the next one is up
+    }
+    if (event.type == SDL_KEYDOWN) {
+        frameDirty = true;
+        if (pendingInputTicks == 0) {
+            pendingInputTicks = event.key.timestamp;
+        }
+        switch (event.key.keysym.sym) {
+            case SDLK_ESCAPE:
+                running = false;
+                break;
+            case SDLK_RETURN:
+                if (currentState == MENU) {
+                    currentState = PLAYING;
+                    resetGame(currentLevelIndex);
+                }
+                break;
+            case SDLK_1: 
+                if (currentState == MENU) {
+                    currentState = PLAYING;
+                    currentLevelIndex = 0; 
+                    resetGame(currentLevelIndex);
+                } else if (currentState == LEVELS) {
+                    currentState = PLAYING;
+                    currentLevelIndex = levelsPage * LEVELS_PER_PAGE; 
+                    resetGame(currentLevelIndex);
+                }
+                break;
+            case SDLK_2:
+                if (currentState == MENU) {
+                    currentState = LEVELS;
+                } else if (currentState == LEVELS && levelsPage * LEVELS_PER_PAGE + 1 < levelCount()) {
+                    currentState = PLAYING;
+                    currentLevelIndex = levelsPage * LEVELS_PER_PAGE + 1; 
+                    resetGame(currentLevelIndex);
+                }
+                break;
+            case SDLK_3: 
+                if (currentState == LEVELS) {
+                    if (levelsPage * LEVELS_PER_PAGE + 2 < levelCount()) {
                         currentState = PLAYING;
-                        currentLevelIndex = 1; 
+                        currentLevelIndex = levelsPage * LEVELS_PER_PAGE + 2; 
                         resetGame(currentLevelIndex);
                     }
-                    break;
-                case SDLK_3: 
-                    if (currentState == LEVELS) {
+                } else {
+                    running = false;
+                }
+                break;
+                 case SDLK_UP:
+                if (currentState == PLAYING) {
+                    movePlayer(0, -1);
+                }
+                break;
+            case SDLK_DOWN:
+                if (currentState == PLAYING) {
+                    movePlayer(0, 1);
+                }
+                break;
+            case SDLK_LEFT:
+                if (currentState == PLAYING) {
+                    movePlayer(-1, 0);
+                } else if (currentState == LEVELS && levelsPage > 0) {
+                    levelsPage--;
+                }
+                break;
+            case SDLK_RIGHT:
+                if (currentState == PLAYING) {
+                    movePlayer(1, 0);
+                } else if (currentState == LEVELS && (levelsPage + 1) * LEVELS_PER_PAGE < levelCount()) {
+                    levelsPage++;
+                }
+                break;
+            case SDLK_PAGEUP:
+                if (currentState == LEVELS) {
+                    levelsPage = std::max(0, levelsPage - LEVELS_PAGE_JUMP);
+                }
+                break;
+            case SDLK_PAGEDOWN:
+                if (currentState == LEVELS) {
+                    int lastPage = std::max(0, (levelCount() - 1) / LEVELS_PER_PAGE);
+                    levelsPage = std::min(lastPage, levelsPage + LEVELS_PAGE_JUMP);
+                }
+                break;
+            case SDLK_SPACE:
+                if (currentState == PLAYING) {
+                    resetGame(currentLevelIndex);
+                    movesCount=0;
+                }
+                break;
+            case SDLK_z:
+            case SDLK_BACKSPACE:
+                if (currentState == PLAYING) {
+                    undoMove();
+                }
+                break;
+            case SDLK_y:
+                if (currentState == PLAYING) {
+                    redoMove();
+                }
+                break;
+            case SDLK_F3:
+                if (currentState == PLAYING) {
+                    std::string moves = history.moves();
+                    std::cout << "Level " << currentLevelIndex + 1 << ": " << moves << std::endl;
+                    SDL_SetClipboardText(moves.c_str());
+                }
+                break;
+            case SDLK_F2:
+                if (currentState == PLAYING) {
+                    warnDeadlocks = !warnDeadlocks;
+                    deadlockWarning = false;
+                }
+                break;
+            case SDLK_F1:
+                if (currentState == PLAYING) {
+                    currentState = MENU;
+                    resetGame(currentLevelIndex);
+                }
+                break;
+            default:
+                if (currentState == LEVELS) {
+                    int firstLevelKey = SDLK_1;
+                    int levelSelected = event.key.keysym.sym - firstLevelKey;
+                    if (levelSelected >= 0 && levelSelected < LEVELS_PER_PAGE &&
+                        levelsPage * LEVELS_PER_PAGE + levelSelected < levelCount()) {
+                        levelSelected += levelsPage * LEVELS_PER_PAGE;
                         currentState = PLAYING;
-                        currentLevelIndex = 2; 
+                        currentLevelIndex = levelSelected;
                         resetGame(currentLevelIndex);
-                    } else {
-                        running = false;
-                    }
-                    break;
-                     case SDLK_UP:
-                    if (currentState == PLAYING) {
-                        movePlayer(0, -1);
-                        movesCount++;
-                    }
-                    break;
-                case SDLK_DOWN:
-                    if (currentState == PLAYING) {
-                        movePlayer(0, 1);
-                        movesCount++;
-                    }
-                    break;
-                case SDLK_LEFT:
-                    if (currentState == PLAYING) {
-                        movePlayer(-1, 0);
-                        movesCount++;
                     }
-                    break;
-                case SDLK_RIGHT:
-                    if (currentState == PLAYING) {
-                        movePlayer(1, 0);
-                        movesCount++;
-                    }
-                    break;
-                case SDLK_SPACE:
-                    if (currentState == PLAYING) {
-                        resetGame(currentLevelIndex);
-                        movesCount=0;
-                    }
-                    break;
-                case SDLK_F1:
-                    if (currentState == PLAYING) {
-                        currentState = MENU;
-                        resetGame(currentLevelIndex);
-                    }
-                    break;
-                default:
-                    if (currentState == LEVELS) {
-                        int firstLevelKey = SDLK_1;
-                        int levelSelected = event.key.keysym.sym - firstLevelKey;
-                        if (levelSelected >= 0 && levelSelected < levels.size()) {
-                            currentState = PLAYING;
-                            currentLevelIndex = levelSelected;
-                            resetGame(currentLevelIndex);
-                        }
-                    }
-                    break;
-            }
+                }
+                break;
         }
     }
 }
 
 void SokobanGame::update() {
-    bool allBoxesOnStorage = true;
-    for (const auto& row : level) {
-        for (const auto& tile : row) {
-            if (tile.type == BOX) {
-                allBoxesOnStorage = false;
-                break;
+    if (!bannerText.empty()) {
+        if (SDL_TICKS_PASSED(SDL_GetTicks(), bannerStart + BANNER_MS)) {
+            bannerText.clear();
+            setAnimating(false);
+            if (quitAfterBanner) {
+                running = false;
+            } else if (currentLevelIndex < levelCount()) {
+                resetGame(currentLevelIndex);
+            } else {
+                bannerText = "Congratulations! You completed all levels!";
+                bannerX = 350;
+                bannerStart = SDL_GetTicks();
+                quitAfterBanner = true;
+                setAnimating(true);
             }
+        } else {
+            setAnimating(true);
         }
-        if (!allBoxesOnStorage) break;
+        return;
     }
+    // The board only changes through movePlayer() and resetGame(); nothing to do otherwise.
+    if (!levelChanged) {
+        return;
+    }
+    levelChanged = false;
+    bool allBoxesOnStorage = level.isSolved();
 
   if (allBoxesOnStorage) {
     movesCount = 0;
-    SDL_Color white = { 255, 255, 255, 255 };
-    SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-    SDL_RenderClear(renderer);
-    renderText("Level Complete!", 450, 350, white);
-    SDL_RenderPresent(renderer);
-    SDL_Delay(1000);
     currentLevelIndex++;
-    if (currentLevelIndex < levels.size()) {
-        resetGame(currentLevelIndex);
-    } else {
-        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-        SDL_RenderClear(renderer);
-        renderText("Congratulations! You completed all levels!", 350, 350, white);
-        SDL_RenderPresent(renderer);
-        SDL_Delay(1000);
-        running = false;
-    }
-}
-
+    bannerText = "Level Complete!";
+    bannerX = 450;
+    bannerStart = SDL_GetTicks();
+    setAnimating(true);
+  }
 }
 
 void SokobanGame::render() {
+    if (!frameDirty) {
+        frameStats.framesSkipped++;
+        return;
+    }
+    frameDirty = false;
+    drawCalls = 0;
     SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
     SDL_RenderClear(renderer);
 
-    switch (currentState) {
+    if (!bannerText.empty()) {
+        Uint32 elapsed = SDL_GetTicks() - bannerStart;
+        Uint8 alpha = elapsed >= BANNER_FADE_MS ? 255 : Uint8(255 * elapsed / BANNER_FADE_MS);
+        SDL_Color white = { 255, 255, 255, 255 };
+        renderText(bannerText, bannerX, 350, white, FONT_SIZE, alpha);
+    } else switch (currentState) {
         case MENU:
             renderMenu();
             break;
@@ -463,19 +686,13 @@ void SokobanGame::render() {
             renderLevelsMenu();
             break;
         case PLAYING:
-            for (const auto& row : level) {
-                for (const auto& tile : row) {
-                    SDL_Rect destRect = { tile.position.x * TILE_SIZE, tile.position.y * TILE_SIZE, TILE_SIZE, TILE_SIZE };
-                    if (textures[tile.type]) {
-                        SDL_RenderCopy(renderer, textures[tile.type], nullptr, &destRect);
-                    }
-                }
-            }
+            flushDirtyCells();
             {
-                SDL_Rect playerRect = { playerPosition.x * TILE_SIZE, playerPosition.y * TILE_SIZE, TILE_SIZE, TILE_SIZE };
-                SDL_RenderCopy(renderer, textures[PLAYER], nullptr, &playerRect);
+                SDL_Rect source;
+                SDL_Rect target;
+                boardPlacement(source, target);
+                drawTexture(boardLayer, &source, &target);
 
-                
                 SDL_Color black = { 0, 0, 0, 0 };
                 std::string movesText = "Moves: " + std::to_string(movesCount); 
                 std::string levelText = "Level: " + std::to_string(currentLevelIndex + 1); 
@@ -483,6 +700,10 @@ void SokobanGame::render() {
                 renderText(levelText, 200, 650, black);
                 renderText("F1 - Main Menu", 60, 700, black);
                 renderText("Spacebar - Reset Level", 600, 700, black);
+                if (deadlockWarning) {
+                    SDL_Color red = { 200, 0, 0, 255 };
+                    renderText("Deadlocked!", 1100, 650, red);
+                }
             }
 
             
@@ -493,106 +714,242 @@ void SokobanGame::render() {
     }
 
     SDL_RenderPresent(renderer);
+    frameStats.framesRendered++;
+    frameStats.lastDrawCalls = drawCalls;
+    pruneTextCache();
 }
 
 
-void SokobanGame::resetGame(int levelIndex) {
-    if (levelIndex >= 0 && levelIndex < levels.size()) {
-        level = levels[levelIndex];
-        for (int y = 0; y < level.size(); ++y) {
-            for (int x = 0; x < level[y].size(); ++x) {
-                if (level[y][x].type == PLAYER) {
-                    playerPosition = { x, y };
-                    return;
-                }
+// The part of the board layer shown (`source`) and where it goes on screen (`target`). Levels
+// whose walls, goals and boxes fit on screen are drawn 1:1 from the corner; the filler around
+// them is simply clipped, and so is less than half a tile of the content itself (level 8 is two
+// pixels too wide). Larger ones are cropped to that content and shrunk to fit, keeping the
+// aspect.
+void SokobanGame::boardPlacement(SDL_Rect& source, SDL_Rect& target) const {
+    int left = level.width();
+    int top = level.height();
+    int right = -1;
+    int bottom = -1;
+    for (int y = 0; y < level.height(); y++) {
+        for (int x = 0; x < level.width(); x++) {
+            if (level.tileAt(x, y) != EMPTY) {
+                left = std::min(left, x);
+                top = std::min(top, y);
+                right = std::max(right, x);
+                bottom = std::max(bottom, y);
             }
         }
     }
+    source = { 0, 0, level.width() * TILE_SIZE, level.height() * TILE_SIZE };
+    target = source;
+    const int overflow = TILE_SIZE / 2;
+    if (right < 0 ||
+        ((right + 1) * TILE_SIZE < SCREEN_WIDTH + overflow && (bottom + 1) * TILE_SIZE < SCREEN_HEIGHT + overflow)) {
+        return;
+    }
+    source = { left * TILE_SIZE, top * TILE_SIZE, (right - left + 1) * TILE_SIZE, (bottom - top + 1) * TILE_SIZE };
+    target = { 0, 0, source.w, source.h };
+    if (target.w >= SCREEN_WIDTH + overflow || target.h >= SCREEN_HEIGHT + overflow) {
+        double scale = std::min(double(SCREEN_WIDTH) / target.w, double(SCREEN_HEIGHT) / target.h);
+        target.w = int(target.w * scale);
+        target.h = int(target.h * scale);
+    }
 }
 
-bool SokobanGame::movePlayer(int dx, int dy) {
-    int newX = playerPosition.x + dx;
-    int newY = playerPosition.y + dy;
 
-    if (newX < 0 || newX >= level[0].size() || newY < 0 || newY >= level.size()) {
-        return false;
+void SokobanGame::resetGame(int levelIndex) {
+    if (levelIndex >= 0 && levelIndex < levelCount()) {
+        saveReplay();
+        // Pack levels are parsed on first use; resets of the same level reuse the copy.
+        if (levelIndex != levelStartIndex) {
+            if (!fetchLevel(levelIndex, levelStart)) {
+                levelStartIndex = -1;
+                return;
+            }
+            levelStartIndex = levelIndex;
+        }
+        level.resetFrom(levelStart);
+        history.clear();
+        recorder.start(levelIndex, levelStart);
+        movesCount = 0;
+        deadlockWarning = false;
+        levelChanged = true;
+        buildBoardLayers();
     }
+}
 
-    Tile& targetTile = level[newY][newX];
-    if (targetTile.type == WALL) {
+bool SokobanGame::movePlayer(int dx, int dy) {
+    bool pushed = false;
+    if (!level.movePlayer(dx, dy, &pushed)) {
         return false;
     }
+    history.record(directionOf(dx, dy), pushed);
+    recorder.move(directionOf(dx, dy), pushed);
+    playerMoved(dx, dy, pushed);
+    return true;
+}
 
-    if (targetTile.type == BOX || targetTile.type == BOX_ON_STORAGE) {
-        int nextX = newX + dx;
-        int nextY = newY + dy;
-        if (nextX < 0 || nextX >= level[0].size() || nextY < 0 || nextY >= level.size()) {
-            return false;
-        }
-        Tile& nextTile = level[nextY][nextX];
-        if (nextTile.type != EMPTY && nextTile.type != STORAGE) {
-            return false;
-        }
+// Walks the player to `target` along a shortest path that pushes nothing, one recorded move per
+// step, so undo and replays see ordinary moves.
+void SokobanGame::walkTo(Point target) {
+    std::vector<int> steps;
+    if (!level.walkPath(target, steps)) {
+        return;
+    }
+    for (int d : steps) {
+        movePlayer(DIR_DX[d], DIR_DY[d]);
+    }
+}
 
-        if (nextTile.type == STORAGE) {
-            nextTile.type = BOX_ON_STORAGE;
-        } else {
-            nextTile.type = BOX;
+// Bookkeeping after the player stepped by (dx, dy), by a new move or a redo.
+void SokobanGame::playerMoved(int dx, int dy, bool pushed) {
+    Point player = level.player();
+    movesCount = history.size();
+    levelChanged = true;
+    markCellDirty({ player.x - dx, player.y - dy });
+    markCellDirty(player);
+    if (pushed) {
+        markCellDirty({ player.x + dx, player.y + dy });
+    }
+    if (pushed && warnDeadlocks && !deadlockWarning) {
+        Point box = { player.x + dx, player.y + dy };
+        if (level.isDead(box.x, box.y) || isFreezeDeadlock(level, box.x, box.y)) {
+            deadlockWarning = true;
+            deadlockMove = history.size();
         }
+    }
+}
 
-        if (targetTile.type == BOX_ON_STORAGE) {
-            targetTile.type = STORAGE;
-        } else {
-            targetTile.type = EMPTY;
-        }
+// Appends the attempt so far to the replay file, if recording, and starts an empty one.
+void SokobanGame::saveReplay() {
+    if (replayPath.empty() || recorder.empty()) {
+        return;
+    }
+    std::ofstream out(replayPath, std::ios::app);
+    out << formatReplay(recorder.replay()) << '\n';
+    if (!out) {
+        std::cerr << "Unable to write replay to " << replayPath << std::endl;
     }
+    recorder = ReplayRecorder();
+}
 
-    if (targetTile.type == STORAGE) {
-        targetTile.type = PLAYER_ON_STORAGE;
-    } else if (targetTile.type == EMPTY) {
-        targetTile.type = PLAYER;
+void SokobanGame::undoMove() {
+    Point from = level.player();
+    int dir = 0;
+    bool pushed = false;
+    if (!history.undo(level, &dir, &pushed)) {
+        return;
     }
-   
-    Tile& playerTile = level[playerPosition.y][playerPosition.x];
-    if (playerTile.type == PLAYER_ON_STORAGE) {
-        playerTile.type = STORAGE;  
-    } else {
-        playerTile.type = EMPTY;  
+    recorder.undo();
+    movesCount = history.size();
+    levelChanged = true;
+    markCellDirty(from);
+    markCellDirty(level.player());
+    if (pushed) {
+        markCellDirty({ from.x + DIR_DX[dir], from.y + DIR_DY[dir] });
     }
+    if (deadlockWarning && history.size() < deadlockMove) {
+        deadlockWarning = false;
+    }
+}
+
+void SokobanGame::redoMove() {
+    int dir = 0;
+    bool pushed = false;
+    if (history.redo(level, &dir, &pushed)) {
+        recorder.move(dir, pushed);
+        playerMoved(DIR_DX[dir], DIR_DY[dir], pushed);
+    }
+}
 
-    playerPosition = { newX, newY };
+bool SokobanGame::loadFonts() {
+    TTF_Font* font = TTF_OpenFont("Pacifico.ttf", FONT_SIZE);
+    if (!font) {
+        std::cerr << "Failed to load font! SDL_ttf Error: " << TTF_GetError() << std::endl;
+        return false;
+    }
+    fonts[FONT_SIZE] = font;
     return true;
 }
 
-void SokobanGame::renderText(const std::string& text, int x, int y, SDL_Color color) {
-    TTF_Font* font = TTF_OpenFont("Pacifico.ttf", 50);
+TTF_Font* SokobanGame::getFont(int size) {
+    auto it = fonts.find(size);
+    if (it != fonts.end()) {
+        return it->second;
+    }
+    // Sizes not preloaded in loadFonts() are opened once and kept for the rest of the session.
+    TTF_Font* font = TTF_OpenFont("Pacifico.ttf", size);
     if (!font) {
         std::cerr << "Failed to load font! SDL_ttf Error: " << TTF_GetError() << std::endl;
-        return;
+        return nullptr;
     }
+    fonts[size] = font;
+    return font;
+}
 
-    SDL_Surface* textSurface = TTF_RenderText_Solid(font, text.c_str(), color);
-    if (!textSurface) {
-        std::cerr << "Unable to render text surface! SDL_ttf Error: " << TTF_GetError() << std::endl;
-        TTF_CloseFont(font);
-        return;
+void SokobanGame::pruneTextCache() {
+    // Drop texts that were not drawn this frame, e.g. the previous "Moves: N" string.
+    for (auto it = textCache.begin(); it != textCache.end();) {
+        if (it->second.lastUsedFrame != frameCounter) {
+            SDL_DestroyTexture(it->second.texture);
+            it = textCache.erase(it);
+        } else {
+            ++it;
+        }
     }
+    frameCounter++;
+}
 
-    SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-    if (!textTexture) {
-        std::cerr << "Unable to create texture from rendered text! SDL Error: " << SDL_GetError() << std::endl;
-    } else {
-        SDL_Rect renderQuad = { x, y, textSurface->w, textSurface->h };
-        SDL_RenderCopy(renderer, textTexture, nullptr, &renderQuad);
-        SDL_DestroyTexture(textTexture);
+void SokobanGame::clearTextCache() {
+    for (auto& pair : textCache) {
+        SDL_DestroyTexture(pair.second.texture);
     }
+    textCache.clear();
+}
+
+void SokobanGame::renderText(const std::string& text, int x, int y, SDL_Color color, int size, Uint8 alpha) {
+    TextKey key = { text, (Uint32(color.r) << 24) | (Uint32(color.g) << 16) | (Uint32(color.b) << 8) | color.a, size };
+    auto it = textCache.find(key);
+    if (it == textCache.end()) {
+        TTF_Font* font = getFont(size);
+        if (!font) {
+            return;
+        }
+
+        SDL_Surface* textSurface = TTF_RenderText_Solid(font, text.c_str(), color);
+        if (!textSurface) {
+            std::cerr << "Unable to render text surface! SDL_ttf Error: " << TTF_GetError() << std::endl;
+            return;
+        }
 
-    SDL_FreeSurface(textSurface);
-    TTF_CloseFont(font);
+        SDL_Texture* textTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
+        if (!textTexture) {
+            std::cerr << "Unable to create texture from rendered text! SDL Error: " << SDL_GetError() << std::endl;
+            SDL_FreeSurface(textSurface);
+            return;
+        }
+
+        CachedText cached = { textTexture, textSurface->w, textSurface->h, frameCounter };
+        SDL_FreeSurface(textSurface);
+        it = textCache.emplace(key, cached).first;
+    }
+
+    it->second.lastUsedFrame = frameCounter;
+    SDL_Rect renderQuad = { x, y, it->second.width, it->second.height };
+    SDL_SetTextureAlphaMod(it->second.texture, alpha);
+    drawTexture(it->second.texture, nullptr, &renderQuad);
 }
 
-int main() {
+// sokoban [--record REPLAYS] [PACK]
+int main(int argc, char* argv[]) {
     SokobanGame game;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--record" && i + 1 < argc) {
+            game.setReplayFile(argv[++i]);
+        } else {
+            game.setLevelPack(argv[i]);
+        }
+    }
     if (!game.initialize()) {
         std::cerr << "Failed to initialize game." << std::endl;
         return 1;
@@ -0,0 +1,374 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "history.h"
+#include "levelpack.h"
+#include "levels.h"
+#include "replay.h"
+
+// Microbenchmarks of the operations a frame or a level change costs, no SDL involved:
+//   sokoban-microbench [--benchmark_filter=TEXT] [--benchmark_min_time=SECONDS]
+//                      [--benchmark_format=console|json] [--benchmark_out=FILE]
+// Every benchmark runs once per built-in level, named "BM_Name/<level>". The flags and the
+// JSON layout follow Google Benchmark, so its compare.py can diff two builds' output.
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Keeps the compiler from discarding a result that is otherwise unused.
+template <typename T>
+void doNotOptimize(const T& value) {
+#if defined(__GNUC__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const void* sink;
+    sink = &value;
+#endif
+}
+
+double cpuSeconds() {
+    return double(std::clock()) / CLOCKS_PER_SEC;
+}
+
+// Handed to a benchmark body, which loops `while (state.keepRunning())` around the timed code
+// and does its setup before the loop.
+class State {
+public:
+    State(int level, uint64_t iterations) : level(level), remaining(iterations), iterations(iterations) {}
+
+    bool keepRunning() {
+        if (!started) {
+            started = true;
+            realStart = Clock::now();
+            cpuStart = cpuSeconds();
+        }
+        if (remaining == 0) {
+            realTime = std::chrono::duration<double>(Clock::now() - realStart).count();
+            cpuTime = cpuSeconds() - cpuStart;
+            return false;
+        }
+        remaining--;
+        return true;
+    }
+
+    // Work items (moves, cells, levels) handled per iteration; reported as items_per_second.
+    void setItemsPerIteration(double items) { itemsPerIteration = items; }
+
+    const int level;  // 0-based built-in level
+
+private:
+    friend struct Run;
+
+    uint64_t remaining;
+    uint64_t iterations;
+    bool started = false;
+    Clock::time_point realStart;
+    double cpuStart = 0.0;
+    double realTime = 0.0;
+    double cpuTime = 0.0;
+    double itemsPerIteration = 0.0;
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(State&)> body;
+};
+
+struct Run {
+    std::string name;
+    uint64_t iterations = 0;
+    double realNs = 0.0;  // per iteration
+    double cpuNs = 0.0;
+    double itemsPerSecond = 0.0;
+
+    // Grows the iteration count until one run lasts `minSeconds`, as Google Benchmark does,
+    // and keeps the timings of that last run.
+    static Run measure(const Benchmark& benchmark, int level, double minSeconds) {
+        Run run;
+        run.name = benchmark.name + "/" + std::to_string(level + 1);
+        uint64_t iterations = 1;
+        while (true) {
+            State state(level, iterations);
+            benchmark.body(state);
+            if (state.realTime >= minSeconds || iterations >= 1000000000ull) {
+                run.iterations = iterations;
+                run.realNs = state.realTime * 1e9 / iterations;
+                run.cpuNs = state.cpuTime * 1e9 / iterations;
+                run.itemsPerSecond = state.realTime > 0.0 ? state.itemsPerIteration * iterations / state.realTime : 0.0;
+                return run;
+            }
+            double scale = state.realTime > 0.0 ? minSeconds * 1.4 / state.realTime : 100.0;
+            scale = scale < 1.5 ? 1.5 : (scale > 10.0 ? 10.0 : scale);
+            iterations = uint64_t(double(iterations) * scale) + 1;
+        }
+    }
+};
+
+std::vector<Board> builtinLevels;
+
+// A fixed pseudo-random walk, so every build times the same sequence of moves.
+std::vector<int> randomWalk(size_t length) {
+    std::vector<int> dirs(length);
+    uint32_t seed = 12345;
+    for (int& dir : dirs) {
+        seed = seed * 1103515245 + 12345;
+        dir = (seed >> 16) % DIRECTION_COUNT;
+    }
+    return dirs;
+}
+
+// Moves along the random walk; blocked moves count too, as a held key costs the same. The
+// board is reset every 1024 moves so boxes pushed into corners do not pin the player.
+void BM_MovePlayer(State& state) {
+    const Board& start = builtinLevels[state.level];
+    std::vector<int> dirs = randomWalk(1024);
+    Board board = start;
+    size_t next = 0;
+    while (state.keepRunning()) {
+        bool pushed = false;
+        doNotOptimize(board.movePlayer(DIR_DX[dirs[next]], DIR_DY[dirs[next]], &pushed));
+        if (++next == dirs.size()) {
+            next = 0;
+            board.resetFrom(start);
+        }
+    }
+    state.setItemsPerIteration(1);
+}
+
+// The headless part of SokobanGame::resetGame(): restore the cached start position and clear
+// the undo history and the replay recording.
+void BM_ResetGame(State& state) {
+    const Board& start = builtinLevels[state.level];
+    Board board = start;
+    MoveHistory history;
+    ReplayRecorder recorder;
+    while (state.keepRunning()) {
+        board.resetFrom(start);
+        history.clear();
+        recorder.start(state.level, start);
+        doNotOptimize(board);
+    }
+    state.setItemsPerIteration(1);
+}
+
+void BM_WinCheck(State& state) {
+    Board board = builtinLevels[state.level];
+    while (state.keepRunning()) {
+        doNotOptimize(board.isSolved());
+    }
+    state.setItemsPerIteration(1);
+}
+
+// Parses the level from the strings loadLevels() uses, dead squares included.
+void BM_ParseBuiltinLevel(State& state) {
+    const std::vector<std::string>& rows = builtinLevelRows(state.level);
+    while (state.keepRunning()) {
+        Board board = parseBuiltinLevel(rows, BUILTIN_LEVEL_WIDTH, BUILTIN_LEVEL_HEIGHT);
+        doNotOptimize(board);
+    }
+    state.setItemsPerIteration(1);
+}
+
+// The same level as pack text, through the parser level packs go through.
+void BM_ParseXsbLevel(State& state) {
+    std::vector<std::string> rows;
+    std::istringstream text(formatXsbLevel(builtinLevels[state.level]));
+    for (std::string row; std::getline(text, row);) {
+        rows.push_back(row);
+    }
+    Board board;
+    std::string error;
+    while (state.keepRunning()) {
+        doNotOptimize(parseXsbLevel(rows, board, error));
+    }
+    state.setItemsPerIteration(1);
+}
+
+struct QueuedSprite {
+    TileType type;
+    int x;
+    int y;
+};
+
+// What buildBoardLayers() prepares before it draws: the sprites of every cell, in order.
+void BM_BoardSprites(State& state) {
+    const Board& board = builtinLevels[state.level];
+    std::vector<QueuedSprite> sprites;
+    sprites.reserve(size_t(board.size()) * 3);
+    while (state.keepRunning()) {
+        sprites.clear();
+        for (int y = 0; y < board.height(); y++) {
+            for (int x = 0; x < board.width(); x++) {
+                TileType layers[3];
+                int count = board.cellSprites(x, y, layers);
+                for (int i = 0; i < count; i++) {
+                    sprites.push_back({ layers[i], x, y });
+                }
+            }
+        }
+        doNotOptimize(sprites.data());
+    }
+    state.setItemsPerIteration(board.size());
+}
+
+// What a frame after a push prepares: the three cells a move can change.
+void BM_DirtyCellSprites(State& state) {
+    Board board = builtinLevels[state.level];
+    Point player = board.player();
+    std::vector<QueuedSprite> sprites;
+    sprites.reserve(9);
+    while (state.keepRunning()) {
+        sprites.clear();
+        for (int step = 0; step < 3; step++) {
+            int x = player.x + step;
+            int y = player.y;
+            TileType layers[3];
+            int count = board.inside(x, y) ? board.cellSprites(x, y, layers) : 0;
+            for (int i = 0; i < count; i++) {
+                sprites.push_back({ layers[i], x, y });
+            }
+        }
+        doNotOptimize(sprites.data());
+    }
+    state.setItemsPerIteration(3);
+}
+
+std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + '"';
+}
+
+void writeJson(std::ostream& out, const std::vector<Run>& runs) {
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S%z", std::localtime(&now));
+#ifdef NDEBUG
+    const char* buildType = "release";
+#else
+    const char* buildType = "debug";
+#endif
+    out << "{\n  \"context\": {\n"
+        << "    \"date\": " << jsonString(date) << ",\n"
+        << "    \"executable\": \"sokoban-microbench\",\n"
+        << "    \"num_cpus\": " << std::thread::hardware_concurrency() << ",\n"
+        << "    \"library_build_type\": \"" << buildType << "\"\n"
+        << "  },\n  \"benchmarks\": [";
+    for (size_t i = 0; i < runs.size(); i++) {
+        const Run& run = runs[i];
+        char timings[160];
+        std::snprintf(timings, sizeof(timings), "\"real_time\": %.4f,\n      \"cpu_time\": %.4f,\n      \"time_unit\": \"ns\"",
+                      run.realNs, run.cpuNs);
+        out << (i ? ",\n" : "\n") << "    {\n"
+            << "      \"name\": " << jsonString(run.name) << ",\n"
+            << "      \"run_name\": " << jsonString(run.name) << ",\n"
+            << "      \"run_type\": \"iteration\",\n"
+            << "      \"iterations\": " << run.iterations << ",\n"
+            << "      " << timings << ",\n"
+            << "      \"items_per_second\": " << std::to_string(run.itemsPerSecond) << "\n"
+            << "    }";
+    }
+    out << "\n  ]\n}\n";
+}
+
+void writeConsoleHeader(std::ostream& out) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-28s %12s %12s %12s %14s\n", "Benchmark", "Time", "CPU", "Iterations", "Items/s");
+    out << line << std::string(82, '-') << std::endl;
+}
+
+void writeConsoleRow(std::ostream& out, const Run& run) {
+    char line[160];
+    std::snprintf(line, sizeof(line), "%-28s %9.1f ns %9.1f ns %12llu %13.4gM", run.name.c_str(), run.realNs, run.cpuNs,
+                  (unsigned long long)run.iterations, run.itemsPerSecond / 1e6);
+    out << line << std::endl;
+}
+
+// Value of "--name=value" if `arg` is that flag, else nullptr.
+const char* flagValue(const char* arg, const char* name) {
+    size_t n = std::strlen(name);
+    return std::strncmp(arg, name, n) == 0 && arg[n] == '=' ? arg + n + 1 : nullptr;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string filter;
+    std::string format = "console";
+    std::string outPath;
+    double minSeconds = 0.5;
+    for (int i = 1; i < argc; i++) {
+        const char* value;
+        if ((value = flagValue(argv[i], "--benchmark_filter"))) {
+            filter = value;
+        } else if ((value = flagValue(argv[i], "--benchmark_min_time"))) {
+            minSeconds = std::atof(value);
+        } else if ((value = flagValue(argv[i], "--benchmark_format"))) {
+            format = value;
+        } else if ((value = flagValue(argv[i], "--benchmark_out"))) {
+            outPath = value;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--benchmark_filter=TEXT] [--benchmark_min_time=SECONDS]"
+                      << " [--benchmark_format=console|json] [--benchmark_out=FILE]" << std::endl;
+            return 1;
+        }
+    }
+    if (format != "console" && format != "json") {
+        std::cerr << "Unknown format " << format << std::endl;
+        return 1;
+    }
+
+    builtinLevels = loadBuiltinLevels();
+    const Benchmark benchmarks[] = {
+        { "BM_MovePlayer", BM_MovePlayer },
+        { "BM_ResetGame", BM_ResetGame },
+        { "BM_WinCheck", BM_WinCheck },
+        { "BM_ParseBuiltinLevel", BM_ParseBuiltinLevel },
+        { "BM_ParseXsbLevel", BM_ParseXsbLevel },
+        { "BM_BoardSprites", BM_BoardSprites },
+        { "BM_DirtyCellSprites", BM_DirtyCellSprites },
+    };
+    if (format == "console") {
+        writeConsoleHeader(std::cout);
+    }
+    std::vector<Run> runs;
+    for (const Benchmark& benchmark : benchmarks) {
+        for (int level = 0; level < int(builtinLevels.size()); level++) {
+            std::string name = benchmark.name + "/" + std::to_string(level + 1);
+            if (name.find(filter) == std::string::npos) {
+                continue;
+            }
+            runs.push_back(Run::measure(benchmark, level, minSeconds));
+            if (format == "console") {
+                writeConsoleRow(std::cout, runs.back());
+            }
+        }
+    }
+    if (format == "json") {
+        writeJson(std::cout, runs);
+    }
+    if (!outPath.empty()) {
+        std::ofstream out(outPath);
+        writeJson(out, runs);
+        if (!out) {
+            std::cerr << "Unable to write " << outPath << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
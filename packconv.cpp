@@ -0,0 +1,19 @@
+#include <iostream>
+#include "binarypack.h"
+
+// Converts a text level pack to the binary format:
+//   sokoban-pack INPUT.xsb OUTPUT.sokb
+int main(int argc, char* argv[]) {
+    if (argc != 3) {
+        std::cerr << "Usage: " << argv[0] << " INPUT.xsb OUTPUT.sokb" << std::endl;
+        return 1;
+    }
+    BinaryPackStats stats;
+    if (!convertToBinaryPack(argv[1], argv[2], &stats)) {
+        return 1;
+    }
+    std::cout << stats.levels << " levels: " << stats.textBytes << " bytes of text, " << stats.binaryBytes << " bytes binary ("
+              << (stats.textBytes ? 100.0 * stats.binaryBytes / stats.textBytes : 0.0) << "%), converted in "
+              << stats.milliseconds << " ms" << std::endl;
+    return 0;
+}
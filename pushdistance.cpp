@@ -0,0 +1,142 @@
+#include "pushdistance.h"
+#include <algorithm>
+
+namespace {
+
+// Floor neighbour of `cell` in direction d, or -1 for a wall or the edge of the board.
+int neighbour(const Board& board, int cell, int d) {
+    int x = cell % board.width() + DIR_DX[d];
+    int y = cell / board.width() + DIR_DY[d];
+    return board.inside(x, y) && !board.isWall(x, y) ? board.index(x, y) : -1;
+}
+
+// For every cell a box can stand on, which of its neighbours the player can walk between while
+// the box blocks the cell: sides[cell * 4 + d] labels the area neighbour d is in (equal labels
+// are connected), or is -1 if that neighbour is a wall or off the board. A box only splits the
+// floor where it stands on an articulation point, so one depth-first search (Tarjan's low-link
+// numbers) answers this for every cell in O(cells).
+std::vector<int8_t> sideAreas(const Board& board) {
+    int cells = board.size();
+    std::vector<int> order(cells, -1);  // discovery time
+    std::vector<int> low(cells, 0);
+    std::vector<int> last(cells, 0);    // last discovery time in the subtree
+    std::vector<int> parent(cells, -1);
+    std::vector<std::pair<int, int>> stack;  // cell, next direction to try
+    int time = 0;
+    for (int root = 0; root < cells; root++) {
+        if (board.isWallAt(root) || order[root] >= 0) {
+            continue;
+        }
+        order[root] = low[root] = time++;
+        stack.push_back({ root, 0 });
+        while (!stack.empty()) {
+            int cell = stack.back().first;
+            if (stack.back().second < DIRECTION_COUNT) {
+                int next = neighbour(board, cell, stack.back().second++);
+                if (next < 0) {
+                    continue;
+                }
+                if (order[next] < 0) {
+                    parent[next] = cell;
+                    order[next] = low[next] = time++;
+                    stack.push_back({ next, 0 });
+                } else if (next != parent[cell]) {
+                    low[cell] = std::min(low[cell], order[next]);
+                }
+                continue;
+            }
+            last[cell] = time - 1;
+            stack.pop_back();
+            if (parent[cell] >= 0) {
+                low[parent[cell]] = std::min(low[parent[cell]], low[cell]);
+            }
+        }
+    }
+
+    // A neighbour below the box in the search tree is cut off with its subtree when no cell of
+    // that subtree links above the box; every other neighbour shares area 0.
+    std::vector<int8_t> sides(size_t(cells) * DIRECTION_COUNT, -1);
+    for (int box = 0; box < cells; box++) {
+        if (board.isWallAt(box)) {
+            continue;
+        }
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            int cell = neighbour(board, box, d);
+            if (cell < 0) {
+                continue;
+            }
+            int8_t area = 0;
+            if (order[cell] > order[box] && order[cell] <= last[box]) {
+                for (int c = 0; c < DIRECTION_COUNT; c++) {
+                    int child = neighbour(board, box, c);
+                    if (child >= 0 && parent[child] == box && order[child] <= order[cell] && order[cell] <= last[child]) {
+                        area = low[child] >= order[box] ? int8_t(1 + c) : 0;
+                        break;
+                    }
+                }
+            }
+            sides[size_t(box) * DIRECTION_COUNT + d] = area;
+        }
+    }
+    return sides;
+}
+
+}  // namespace
+
+PushDistanceTable::PushDistanceTable(const Board& board) {
+    int cells = board.size();
+    for (int i = 0; i < cells; i++) {
+        if (board.isGoalAt(i) && !board.isWallAt(i)) {
+            goals.push_back(i);
+        }
+    }
+    distances.assign(size_t(cells) * goals.size(), PUSH_DISTANCE_UNREACHABLE);
+    if (goals.empty()) {
+        return;
+    }
+    std::vector<int8_t> sides = sideAreas(board);
+
+    // Breadth-first over (box cell, player side) states, pulling the box away from the goal:
+    // with the player on side d of the box, it can walk to any side in the same area, and from
+    // side e pull the box onto that side's cell if the cell beyond it is free.
+    std::vector<uint16_t> stateDistance(size_t(cells) * DIRECTION_COUNT);
+    std::vector<int> queue(size_t(cells) * DIRECTION_COUNT);
+    for (size_t j = 0; j < goals.size(); j++) {
+        std::fill(stateDistance.begin(), stateDistance.end(), PUSH_DISTANCE_UNREACHABLE);
+        int head = 0;
+        int tail = 0;
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            int state = goals[j] * DIRECTION_COUNT + d;
+            if (sides[state] >= 0) {
+                stateDistance[state] = 0;
+                queue[tail++] = state;
+            }
+        }
+        while (head < tail) {
+            int state = queue[head++];
+            int box = state / DIRECTION_COUNT;
+            int area = sides[state];
+            int bx = box % board.width();
+            int by = box / board.width();
+            for (int e = 0; e < DIRECTION_COUNT; e++) {
+                if (sides[size_t(box) * DIRECTION_COUNT + e] != area) {
+                    continue;
+                }
+                int px = bx + DIR_DX[e] * 2;
+                int py = by + DIR_DY[e] * 2;
+                if (!board.inside(px, py) || board.isWall(px, py)) {
+                    continue;
+                }
+                int next = board.index(bx + DIR_DX[e], by + DIR_DY[e]) * DIRECTION_COUNT + e;
+                if (stateDistance[next] == PUSH_DISTANCE_UNREACHABLE) {
+                    stateDistance[next] = uint16_t(stateDistance[state] + 1);
+                    queue[tail++] = next;
+                }
+            }
+        }
+        for (int cell = 0; cell < cells; cell++) {
+            const uint16_t* perSide = stateDistance.data() + size_t(cell) * DIRECTION_COUNT;
+            distances[size_t(cell) * goals.size() + j] = *std::min_element(perSide, perSide + DIRECTION_COUNT);
+        }
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef SOKOBAN_PUSHDISTANCE_H
+#define SOKOBAN_PUSHDISTANCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "board.h"
+
+
+// Stored for a goal a box on that cell can never be pushed to.
+const uint16_t PUSH_DISTANCE_UNREACHABLE = 0xffff;
+
+
+// The fewest pushes that take a lone box from each cell to each goal, honouring where the
+// player can stand: a box is only pushed from a side the player can walk to without moving it.
+// Built once per level and never modified afterwards, so one table can be shared by any number
+// of threads. Cells index the board it was built from; goals are numbered in cell order.
+class PushDistanceTable {
+public:
+    explicit PushDistanceTable(const Board& board);
+
+    int goalCount() const { return int(goals.size()); }
+    int goalCell(int goal) const { return goals[goal]; }
+
+    // Minimum over the sides the player may start on.
+    uint16_t distance(int goal, int cell) const { return distances[size_t(cell) * goals.size() + goal]; }
+
+    // All goals' distances for one cell, contiguous.
+    const uint16_t* row(int cell) const { return distances.data() + size_t(cell) * goals.size(); }
+
+    size_t memoryBytes() const { return distances.size() * sizeof(uint16_t) + goals.size() * sizeof(int); }
+
+private:
+    std::vector<int> goals;
+    std::vector<uint16_t> distances;  // per cell, per goal
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "replay.h"
+#include <cstdlib>
+#include <ctime>
+#include "levelpack.h"
+
+uint64_t levelHash(const Board& board) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : formatXsbLevel(board)) {
+        hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string formatReplay(const Replay& replay) {
+    static const char digits[] = "0123456789abcdef";
+    std::string line = std::to_string(replay.level + 1) + '\t';
+    for (int shift = 60; shift >= 0; shift -= 4) {
+        line += digits[(replay.levelHash >> shift) & 15];
+    }
+    line += '\t' + std::to_string(replay.started) + '\t' + replay.moves + '\t';
+    for (size_t i = 0; i < replay.times.size(); i++) {
+        if (i > 0) {
+            line += ',';
+        }
+        line += std::to_string(replay.times[i]);
+    }
+    return line;
+}
+
+bool parseReplay(const std::string& line, Replay& replay, std::string& error) {
+    std::vector<std::string> fields;
+    size_t begin = 0;
+    while (true) {
+        size_t tab = line.find('\t', begin);
+        fields.push_back(line.substr(begin, tab == std::string::npos ? std::string::npos : tab - begin));
+        if (tab == std::string::npos) {
+            break;
+        }
+        begin = tab + 1;
+    }
+    if (!fields.empty() && !fields.back().empty() && fields.back().back() == '\r') {
+        fields.back().pop_back();
+    }
+    if (fields.size() != 4 && fields.size() != 5) {
+        error = "expected 4 or 5 tab-separated fields";
+        return false;
+    }
+
+    char* end = nullptr;
+    long level = std::strtol(fields[0].c_str(), &end, 10);
+    if (*end != '\0' || level < 1) {
+        error = "bad level number";
+        return false;
+    }
+    replay.level = int(level - 1);
+    replay.levelHash = std::strtoull(fields[1].c_str(), &end, 16);
+    if (fields[1].size() != 16 || *end != '\0') {
+        error = "bad level hash";
+        return false;
+    }
+    replay.started = std::strtoll(fields[2].c_str(), &end, 10);
+    if (*end != '\0') {
+        error = "bad start time";
+        return false;
+    }
+    replay.moves = fields[3];
+
+    replay.times.clear();
+    if (fields.size() == 5 && !fields[4].empty()) {
+        const char* p = fields[4].c_str();
+        while (true) {
+            replay.times.push_back(uint32_t(std::strtoul(p, &end, 10)));
+            if (end == p || (*end != ',' && *end != '\0')) {
+                error = "bad move time";
+                return false;
+            }
+            if (*end == '\0') {
+                break;
+            }
+            p = end + 1;
+        }
+        if (replay.times.size() != replay.moves.size()) {
+            error = "move times do not match the moves";
+            return false;
+        }
+    }
+    return true;
+}
+
+ReplayCheck verifyReplay(const Board& start, const Replay& replay) {
+    ReplayCheck check;
+    Board board = start;
+    for (size_t i = 0; i < replay.moves.size(); i++) {
+        char c = replay.moves[i];
+        int dir = 0;
+        while (dir < DIRECTION_COUNT && DIR_MOVE_CHAR[dir] != c && DIR_PUSH_CHAR[dir] != c) {
+            dir++;
+        }
+        if (dir == DIRECTION_COUNT) {
+            check.error = "move " + std::to_string(i + 1) + " is not one of lurdLURD";
+            return check;
+        }
+        bool pushed = false;
+        if (!board.movePlayer(DIR_DX[dir], DIR_DY[dir], &pushed)) {
+            check.error = "move " + std::to_string(i + 1) + " is blocked";
+            return check;
+        }
+        if (pushed != (c == DIR_PUSH_CHAR[dir])) {
+            check.error = "move " + std::to_string(i + 1) + (pushed ? " pushes a box" : " does not push a box");
+            return check;
+        }
+        check.pushes += pushed;
+        check.moves++;
+    }
+    check.valid = true;
+    check.solved = board.isSolved();
+    check.milliseconds = replay.times.empty() ? 0 : replay.times.back();
+    return check;
+}
+
+void ReplayRecorder::start(int level, const Board& board) {
+    current = Replay();
+    current.level = level;
+    current.levelHash = levelHash(board);
+    current.started = int64_t(std::time(nullptr));
+    startedAt = std::chrono::steady_clock::now();
+}
+
+void ReplayRecorder::move(int dir, bool pushed) {
+    current.moves += pushed ? DIR_PUSH_CHAR[dir] : DIR_MOVE_CHAR[dir];
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - startedAt);
+    current.times.push_back(uint32_t(elapsed.count()));
+}
+
+void ReplayRecorder::undo() {
+    if (!current.moves.empty()) {
+        current.moves.pop_back();
+        current.times.pop_back();
+    }
+}
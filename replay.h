@@ -0,0 +1,64 @@
+#ifndef SOKOBAN_REPLAY_H
+#define SOKOBAN_REPLAY_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "board.h"
+
+
+// One recorded attempt at a level. Replay files hold one replay per line, tab separated:
+//   level number (1-based), level hash (16 hex digits), start time (Unix seconds),
+//   moves (LURD, uppercase letters are pushes), comma-separated milliseconds since the start
+//   at which each move was made (may be empty)
+// Lines starting with '#' are comments.
+struct Replay {
+    int level = 0;  // 0-based
+    uint64_t levelHash = 0;
+    int64_t started = 0;
+    std::string moves;
+    std::vector<uint32_t> times;
+};
+
+
+struct ReplayCheck {
+    bool valid = false;   // every move was legal and matched its push flag
+    bool solved = false;  // the level was solved by the last move
+    int moves = 0;
+    int pushes = 0;
+    uint32_t milliseconds = 0;  // time of the last move
+    std::string error;
+};
+
+
+// Identifies a level by its layout: FNV-1a of formatXsbLevel(board) for the unsolved board.
+uint64_t levelHash(const Board& board);
+
+std::string formatReplay(const Replay& replay);
+
+// Parses one line. Returns false and sets `error` for a malformed line.
+bool parseReplay(const std::string& line, Replay& replay, std::string& error);
+
+// Plays `replay` from `start` through Board::movePlayer(). The level hash is not checked
+// here; callers compare it against levelHash(start), which they can compute once per level.
+ReplayCheck verifyReplay(const Board& start, const Replay& replay);
+
+
+// Records the moves of one attempt as they are made, undo included, so the replay holds
+// the moves that are on the board at the end.
+class ReplayRecorder {
+public:
+    void start(int level, const Board& board);
+    void move(int dir, bool pushed);
+    void undo();
+
+    bool empty() const { return current.moves.empty(); }
+    const Replay& replay() const { return current; }
+
+private:
+    Replay current;
+    std::chrono::steady_clock::time_point startedAt;
+};
+
+#endif
@@ -6,29 +6,102 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
 #include "inc/SDL_ttf.h"
 #include "inc/SDL_mixer.h"
+#include "board.h"
+#include "levels.h"
+#include "levelpack.h"
+#include "binarypack.h"
+#include "deadlock.h"
+#include "history.h"
+#include "replay.h"
 
 
 const int SCREEN_WIDTH = 1366;
 const int SCREEN_HEIGHT = 768;
 const int TILE_SIZE = 57;
+const int FONT_SIZE = 50;
+const int LEVELS_PER_PAGE = 9;       // number keys 1-9 pick from the current page
+const int LEVELS_PAGE_JUMP = 10;     // pages skipped by PgUp/PgDn
+const int LEVELS_MENU_X = 100;
+const int LEVELS_MENU_FONT_SIZE = 32;
+const Uint32 IDLE_WAIT_MS = 250;     // longest the loop sleeps in SDL_WaitEventTimeout
+const Uint32 BANNER_MS = 1000;       // how long "Level Complete!" stays up
+const Uint32 BANNER_FADE_MS = 250;   // fade-in at the start of the banner
 
 
 enum GameState { MENU, PLAYING, LEVELS, QUIT };
 
 
-enum TileType { EMPTY, WALL, BOX, PLAYER, STORAGE, BOX_ON_STORAGE, PLAYER_ON_STORAGE };
+enum LevelSource { SOURCE_BUILTIN, SOURCE_TEXT_PACK, SOURCE_BINARY_PACK };
 
 
-struct Point {
-    int x, y;
+struct AssetStats {
+    Uint64 hits;
+    Uint64 misses;
+    Uint64 uploadBytes;
 };
 
 
-struct Tile {
-    TileType type;
-    Point position;
+struct FrameStats {
+    Uint64 framesRendered;
+    Uint64 framesSkipped;
+    int lastDrawCalls;
+};
+
+
+// Power-of-two buckets from 0.25 ms upwards; the last bucket takes everything slower.
+struct TimingHistogram {
+    static const int BUCKETS = 12;
+    Uint64 counts[BUCKETS] = {};
+    Uint64 samples = 0;
+    double maxMs = 0.0;
+
+    static double bucketLimit(int bucket) { return 0.25 * double(1 << bucket); }
+
+    void add(double ms) {
+        int bucket = 0;
+        while (bucket < BUCKETS - 1 && ms > bucketLimit(bucket)) {
+            bucket++;
+        }
+        counts[bucket]++;
+        samples++;
+        if (ms > maxMs) maxMs = ms;
+    }
+
+    // Upper limit of the bucket holding the p-th percentile.
+    double percentile(double p) const {
+        Uint64 wanted = Uint64(p / 100.0 * double(samples) + 0.5);
+        Uint64 seen = 0;
+        for (int bucket = 0; bucket < BUCKETS - 1; bucket++) {
+            seen += counts[bucket];
+            if (seen >= wanted) return bucketLimit(bucket);
+        }
+        return maxMs;
+    }
+};
+
+
+struct TextKey {
+    std::string text;
+    Uint32 color;
+    int size;
+
+    bool operator<(const TextKey& other) const {
+        if (size != other.size) return size < other.size;
+        if (color != other.color) return color < other.color;
+        return text < other.text;
+    }
+};
+
+
+struct CachedText {
+    SDL_Texture* texture;
+    int width, height;
+    Uint64 lastUsedFrame;
 };
 
 
@@ -37,37 +110,110 @@ public:
     SokobanGame();
     ~SokobanGame();
     bool initialize();
+    void setLevelPack(const std::string& path) { levelPackPath = path; }
+    void setReplayFile(const std::string& path) { replayPath = path; }
     void run();
     void cleanup();
+    const AssetStats& getAssetStats() const { return assetStats; }
+    const FrameStats& getFrameStats() const { return frameStats; }
+    const TimingHistogram& getFrameTimes() const { return frameTimes; }
+    const TimingHistogram& getInputLatency() const { return inputLatency; }
 
 
 private:
     void processInput();
+    void handleEvent(const SDL_Event& event);
+    void setAnimating(bool on);
     void update();
     void render();
     void renderMenu();
     void renderLevelsMenu();
     void resetGame(int levelIndex);
+    int levelCount() const;
+    bool fetchLevel(int index, Board& board) const;
+    std::string levelSummary(int index) const;
     bool movePlayer(int dx, int dy);
-    void renderText(const std::string& text, int x, int y, SDL_Color color);
+    void walkTo(Point target);
+    void playerMoved(int dx, int dy, bool pushed);
+    void undoMove();
+    void redoMove();
+    void saveReplay();
+    void renderText(const std::string& text, int x, int y, SDL_Color color, int size = FONT_SIZE, Uint8 alpha = 255);
+    bool loadFonts();
+    TTF_Font* getFont(int size);
+    void pruneTextCache();
+    void clearTextCache();
     void loadLevels();
     void loadTextures();
     void loadMusic();
     SDL_Texture* loadTexture(const std::string& path, SDL_Renderer* renderer);
+    SDL_Texture* getTexture(const std::string& path);
+    void drawTexture(SDL_Texture* texture, const SDL_Rect* src, const SDL_Rect* dst);
+    void boardPlacement(SDL_Rect& source, SDL_Rect& target) const;
+    void buildBoardLayers();
+    void buildTileAtlas();
+    void queueSprite(TileType type, int x, int y);
+    void queueBoardCell(int x, int y);
+    void flushSprites();
+    void flushDirtyCells();
+    void markCellDirty(Point cell);
 
 
     SDL_Window* window;
     SDL_Renderer* renderer;
     bool running;
-    std::vector<std::vector<std::vector<Tile>>> levels;
-    std::vector<std::vector<Tile>> level;
-    Point playerPosition;
+    std::string levelPackPath;  // XSB or .sokb pack to play instead of the built-in levels
+    LevelSource levelSource = SOURCE_BUILTIN;
+    IndexedLevelPack pack;
+    BinaryLevelPack binaryPack;
+    std::vector<Board> levels;  // built-in levels, used when there is no pack
+    Board levelStart;           // pristine copy of the current level for resets
+    int levelStartIndex = -1;
+    int levelsPage = 0;
+    Board level;
     int currentLevelIndex;
     int movesCount = 0;
+    bool levelChanged = true;
+    bool warnDeadlocks = true;
+    bool deadlockWarning = false;
+    int deadlockMove = 0;  // history size right after the push that raised deadlockWarning
+    MoveHistory history;
+    std::string replayPath;  // replays are appended here when set, see replay.h
+    ReplayRecorder recorder;
     GameState currentState;
     Mix_Music* backgroundMusic;
-    std::map<TileType, SDL_Texture*> textures;
-
+    // All tile sprites scaled to TILE_SIZE and packed into one texture, so a batch of cells is
+    // a single SDL_RenderGeometry call. Sprites that failed to load have no source rect.
+    SDL_Texture* tileAtlas = nullptr;
+    int atlasWidth = 0;
+    std::map<TileType, SDL_Rect> tileRects;
+    std::vector<SDL_Vertex> batchVertices;
+    std::vector<int> batchIndices;
+    std::map<GameState, SDL_Texture*> backgrounds;
+    std::map<std::string, SDL_Texture*> textureAssets;
+    AssetStats assetStats = { 0, 0, 0 };
+    std::map<int, TTF_Font*> fonts;
+    std::map<TextKey, CachedText> textCache;
+    Uint64 frameCounter = 0;
+
+    // Retained board layer, composited once per resetGame() and patched per dirty cell.
+    SDL_Texture* boardLayer = nullptr;
+    std::vector<Point> dirtyCells;
+    bool frameDirty = true;
+    int drawCalls = 0;
+    FrameStats frameStats = { 0, 0, 0 };
+
+    // Scheduler: the loop sleeps in SDL_WaitEventTimeout unless something animates, in which
+    // case frames are paced by vsync. The level-complete banner is the only animation so far.
+    bool animating = false;
+    bool vsyncOn = false;
+    std::string bannerText;
+    int bannerX = 0;
+    Uint32 bannerStart = 0;
+    bool quitAfterBanner = false;
+    Uint32 pendingInputTicks = 0;  // timestamp of the oldest input not yet on screen, 0 if none
+    TimingHistogram frameTimes;
+    TimingHistogram inputLatency;
 };
 
 #endif
@@ -0,0 +1,153 @@
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "binarypack.h"
+#include "levelpack.h"
+#include "levels.h"
+#include "solver.h"
+
+// Headless solver for the built-in levels or a text (XSB) or binary (.sokb) pack:
+//   sokoban-solve [--ida | --hda THREADS | --bidirectional] [--manhattan] [--speedup] [--max-nodes N]
+//                 [--time-limit SECONDS] [--table-mb MB] [--moves] [--pack FILE] [LEVEL...]
+// --manhattan bounds positions by Manhattan distances instead of push distances.
+// --speedup runs hash-distributed A* on every level at 1, 2, 4, 8 and 16 threads and compares
+// each run's time with the single-threaded one.
+namespace {
+
+void printSpeedup(const std::vector<Board>& levels, const std::vector<int>& selected, SolverOptions options) {
+    const int threadCounts[] = { 1, 2, 4, 8, 16 };
+    options.algorithm = SOLVER_HDASTAR;
+    for (int index : selected) {
+        double baseMs = 0.0;
+        // Built once per level so every thread count shares it and no run pays for it.
+        if (options.heuristic == HEURISTIC_PUSHES) {
+            options.pushDistances = std::make_shared<const PushDistanceTable>(levels[index]);
+        }
+        for (int threads : threadCounts) {
+            options.threads = threads;
+            SolverResult result = solveLevel(levels[index], options);
+            if (threads == 1) {
+                baseMs = result.stats.milliseconds;
+            }
+            std::cout << "Level " << index + 1 << ", " << threads << " threads: "
+                      << (result.solved ? std::to_string(result.pushes) + " pushes" : std::string("not solved")) << ", "
+                      << result.stats.expanded << " expanded, " << result.stats.milliseconds << " ms, "
+                      << result.stats.expanded * 1000.0 / std::max(result.stats.milliseconds, 0.001) << " nodes/s, speedup "
+                      << baseMs / std::max(result.stats.milliseconds, 0.001) << std::endl;
+        }
+    }
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    SolverOptions options;
+    bool printMoves = false;
+    bool speedup = false;
+    std::vector<int> selected;
+    std::string packPath;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--ida") == 0) {
+            options.algorithm = SOLVER_IDASTAR;
+        } else if (std::strcmp(argv[i], "--hda") == 0 && i + 1 < argc) {
+            options.algorithm = SOLVER_HDASTAR;
+            options.threads = std::max(1, std::atoi(argv[++i]));
+        } else if (std::strcmp(argv[i], "--bidirectional") == 0) {
+            options.algorithm = SOLVER_BIDIRECTIONAL;
+        } else if (std::strcmp(argv[i], "--goal-macros") == 0) {
+            options.goalMacros = true;
+        } else if (std::strcmp(argv[i], "--manhattan") == 0) {
+            options.heuristic = HEURISTIC_MANHATTAN;
+        } else if (std::strcmp(argv[i], "--speedup") == 0) {
+            speedup = true;
+        } else if (std::strcmp(argv[i], "--max-nodes") == 0 && i + 1 < argc) {
+            options.maxNodes = std::strtoull(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--time-limit") == 0 && i + 1 < argc) {
+            options.timeLimit = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "--table-mb") == 0 && i + 1 < argc) {
+            options.tableBytes = size_t(std::strtoull(argv[++i], nullptr, 10)) << 20;
+        } else if (std::strcmp(argv[i], "--moves") == 0) {
+            printMoves = true;
+        } else if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            packPath = argv[++i];
+        } else {
+            int level = std::atoi(argv[i]);
+            if (level < 1) {
+                std::cerr << "Unknown argument: " << argv[i] << std::endl;
+                return 1;
+            }
+            selected.push_back(level - 1);
+        }
+    }
+
+    std::vector<Board> levels;
+    if (packPath.empty()) {
+        levels = loadBuiltinLevels();
+    } else if (BinaryLevelPack::isBinaryPackPath(packPath)) {
+        if (!loadBinaryPack(packPath, levels)) {
+            return 1;
+        }
+    } else {
+        LevelPackStats stats;
+        if (!loadLevelPack(packPath, levels, &stats)) {
+            return 1;
+        }
+        std::cout << "Loaded " << stats.levels << " levels (" << stats.rejected << " rejected, " << stats.bytes << " bytes) in "
+                  << stats.milliseconds << " ms: " << stats.levelsPerSecond() << " levels/s, " << stats.megabytesPerSecond()
+                  << " MB/s" << std::endl;
+    }
+    for (int index : selected) {
+        if (index >= int(levels.size())) {
+            std::cerr << "No level " << index + 1 << ", there are " << levels.size() << std::endl;
+            return 1;
+        }
+    }
+    if (selected.empty()) {
+        for (int i = 0; i < int(levels.size()); i++) {
+            selected.push_back(i);
+        }
+    }
+
+    if (speedup) {
+        printSpeedup(levels, selected, options);
+        return 0;
+    }
+
+    int solvedCount = 0;
+    double totalMs = 0.0;
+    for (int index : selected) {
+        SolverResult result = solveLevel(levels[index], options);
+        totalMs += result.stats.milliseconds;
+        std::cout << "Level " << index + 1 << ": ";
+        if (result.solved) {
+            solvedCount++;
+            std::cout << "solved, " << result.pushes << " pushes, " << result.moves.size() << " moves";
+        } else if (result.stats.limit == LIMIT_UNSUPPORTED) {
+            std::cout << "not solved, fewer goals than boxes";
+        } else {
+            std::cout << "not solved";
+        }
+        std::cout << ", " << result.stats.expanded << " expanded, " << result.stats.generated << " generated, "
+                  << result.stats.duplicates << " duplicates, " << result.stats.deadlocks << " deadlocks, " << result.stats.table.hits << " table hits, "
+                  << result.stats.table.evictions << " evictions, " << result.stats.table.collisions << " collisions, " << result.stats.memoryBytes / 1024 << " KB, "
+                  << result.stats.milliseconds << " ms" << std::endl;
+        if (options.algorithm == SOLVER_BIDIRECTIONAL) {
+            const MeetingStats& meeting = result.stats.meeting;
+            std::cout << "  " << meeting.forwardStates << " forward and " << meeting.backwardStates << " backward states, "
+                      << meeting.meetings << " meetings";
+            if (result.solved) {
+                std::cout << ", met after " << meeting.forwardDepth << " pushes and " << meeting.backwardDepth << " pulls";
+            }
+            std::cout << std::endl;
+        }
+        if (printMoves && result.solved) {
+            std::cout << "  " << result.moves << std::endl;
+        }
+    }
+    std::cout << solvedCount << "/" << selected.size() << " solved in " << totalMs << " ms" << std::endl;
+    return solvedCount == int(selected.size()) ? 0 : 2;
+}
@@ -0,0 +1,1730 @@
+#include "solver.h"
+#include "deadlock.h"
+#include "heuristic.h"
+#include "mailbox.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+const int NO_SOLUTION = HEURISTIC_UNSOLVABLE;
+
+
+struct Push {
+    int from;
+    int dir;
+};
+
+
+// The search runs on a copy of the level surrounded by a ring of walls, so walking
+// with Board::offset() never leaves the grid and no bounds checks are needed.
+Board padBoard(const Board& board) {
+    Board padded(board.width() + 2, board.height() + 2);
+    for (int y = 0; y < padded.height(); y++) {
+        for (int x = 0; x < padded.width(); x++) {
+            int bx = x - 1;
+            int by = y - 1;
+            if (!board.inside(bx, by)) {
+                padded.setWall(x, y, true);
+                continue;
+            }
+            padded.setWall(x, y, board.isWall(bx, by));
+            padded.setGoal(x, y, board.isGoal(bx, by));
+            padded.setFlag(x, y, CELL_DEAD, board.isDead(bx, by));
+            padded.setBox(x, y, board.hasBox(bx, by));
+        }
+    }
+    padded.setPlayer({ board.player().x + 1, board.player().y + 1 });
+    return padded;
+}
+
+
+// Applies `boxes[k] = to` and restores ascending order, which keeps states canonical.
+void moveBox(uint16_t* boxes, int count, int k, int to) {
+    boxes[k] = uint16_t(to);
+    while (k > 0 && boxes[k - 1] > boxes[k]) {
+        std::swap(boxes[k - 1], boxes[k]);
+        k--;
+    }
+    while (k + 1 < count && boxes[k + 1] < boxes[k]) {
+        std::swap(boxes[k + 1], boxes[k]);
+        k++;
+    }
+}
+
+
+// Static level data plus the scratch buffers shared by both search algorithms.
+class SearchSpace {
+public:
+    // `pushes` is the level's push distance table, needed for HEURISTIC_PUSHES only.
+    SearchSpace(const Board& board, size_t tableBytes, HeuristicKind heuristicKind, const PushDistanceTable* pushes)
+        : start(padBoard(board)), work(start), boxCount(0), keys(start.size()), table(tableBytes),
+          matching(start, heuristicKind, pushes, 1), geometry(start.width(), start.height()),
+          bitboards(start.hasBitboards()), waiting(0), stamp(0), childStamp(0) {
+        for (int i = 0; i < work.size(); i++) {
+            if (work.hasBoxAt(i)) {
+                startBoxes.push_back(uint16_t(i));
+                work.setBoxAt(i, false);
+            }
+            if (work.isGoalAt(i)) {
+                goals.push_back(i);
+            }
+        }
+        boxCount = int(startBoxes.size());
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            offsets[d] = work.offset(d);
+        }
+        visit.assign(work.size(), 0);
+        childVisit.assign(work.size(), 0);
+        queue.resize(work.size());
+        startPlayer = uint16_t(start.index(start.player().x, start.player().y));
+        deadBits.clear();
+        packingZone.clear();
+        for (int i = 0; i < work.size(); i++) {
+            deadBits.assign(i, work.isDeadAt(i));
+        }
+    }
+
+    void placeBoxes(const uint16_t* boxes, bool on) {
+        for (int k = 0; k < boxCount; k++) {
+            work.setBoxAt(boxes[k], on);
+        }
+    }
+
+    // Flood fills the cells the player can walk to from `from` with the boxes currently
+    // placed and returns the smallest reachable index, the canonical player position.
+    // Boards that fit a bitboard use Board::reachability(), which also lists the pushes, and
+    // narrow those to one PI-corral's (see limitToCorral).
+    int reach(int from) {
+        if (bitboards) {
+            region = work.reachability(from, geometry);
+            limitToCorral();
+            return region.canonical;
+        }
+        return floodFill(from, visit, ++stamp);
+    }
+
+    bool reachable(int i) const { return bitboards ? region.cells.test(i) : visit[i] == stamp; }
+
+    // The box on `cell` can be pushed in direction d from the last reach() region.
+    bool canPush(int cell, int d) const {
+        if (bitboards) {
+            return region.pushes[d].test(cell);
+        }
+        return work.isFreeAt(cell + offsets[d]) && visit[cell - offsets[d]] == stamp;
+    }
+
+    // Same as reach() but leaves the last reach() region alone.
+    int normalize(int from) {
+        if (bitboards) {
+            return work.reachFrom(from, geometry).first();
+        }
+        return floodFill(from, childVisit, ++childStamp);
+    }
+
+    // Lower bound on the remaining pushes for `boxes`, from a full matching.
+    int heuristic(const uint16_t* boxes) {
+        return matching.solve(boxes, boxCount);
+    }
+
+    // Readies childHeuristic() for the children of `boxes`.
+    void prepareChildren(const uint16_t* boxes) {
+        if (matching.kind() != HEURISTIC_MANHATTAN) {
+            matching.solve(boxes, boxCount);
+        }
+    }
+
+    // The bound for `child`, which is the boxes last given to heuristic() with box `k` pushed
+    // to `to` (and reordered).
+    int childHeuristic(const uint16_t* child, int k, int to) {
+        if (matching.kind() == HEURISTIC_MANHATTAN) {
+            return matching.solve(child, boxCount);
+        }
+        return matching.childBound(k, to);
+    }
+
+    // True if the box just moved to `cell` is part of a freeze deadlock.
+    bool frozen(int cell) const {
+        return isFreezeDeadlock(work, cell % work.width(), cell / work.width());
+    }
+
+    // True if the push that just moved a box to `cell`, leaving the player on `player`,
+    // caused a freeze or cluster deadlock.
+    bool deadlocked(int cell, int player) {
+        return frozen(cell) || (!getenv("NOCLUSTER") && clusterDeadlock(cell, player));
+    }
+
+    // Walking path for the player between two cells with the current boxes placed.
+    std::string walk(int from, int to) {
+        std::vector<int> previous(work.size(), -1);
+        std::vector<int> previousDir(work.size(), -1);
+        int head = 0;
+        int tail = 0;
+        queue[tail++] = from;
+        previous[from] = from;
+        while (head < tail && previous[to] < 0) {
+            int cell = queue[head++];
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                int next = cell + offsets[d];
+                if (previous[next] < 0 && work.isFreeAt(next)) {
+                    previous[next] = cell;
+                    previousDir[next] = d;
+                    queue[tail++] = next;
+                }
+            }
+        }
+        std::string path;
+        for (int cell = to; cell != from; cell = previous[cell]) {
+            path += DIR_MOVE_CHAR[previousDir[cell]];
+        }
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    // Readies goal macros: finds a floor cell off the goals for the player to wait on while
+    // boxes are pulled off them, and the cells boxes can arrive on. Returns false if the board
+    // is too big for bitboards, has more than 64 goals, or its solved position cannot be
+    // unpacked (see packable()).
+    bool planPacking() {
+        if (!bitboards || goals.size() > 64) {
+            return false;
+        }
+        Bitboard floor = geometry.inside.andNot(work.wallBits());
+        Bitboard seed;
+        seed.clear();
+        seed.set(startPlayer);
+        Bitboard outside = geometry.floodFill(seed, floor).andNot(work.goalBits());
+        if (outside.none()) {
+            return false;
+        }
+        waiting = outside.first();
+        // Cells some box can be pushed onto from where it starts without crossing a goal,
+        // walls permitting.
+        arrivals.assign(work.size(), 0);
+        std::vector<int> cells(startBoxes.begin(), startBoxes.end());
+        for (int cell : cells) {
+            arrivals[cell] = 1;
+        }
+        for (size_t next = 0; next < cells.size(); next++) {
+            if (work.isGoalAt(cells[next])) {
+                continue;
+            }
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                int to = cells[next] + offsets[d];
+                if (!arrivals[to] && !work.isWallAt(to) && !work.isWallAt(cells[next] - offsets[d])) {
+                    arrivals[to] = 1;
+                    cells.push_back(to);
+                }
+            }
+        }
+        goalIndex.assign(work.size(), -1);
+        for (int i = 0; i < int(goals.size()); i++) {
+            goalIndex[goals[i]] = i;
+        }
+        packingZone = work.goalBits() | geometry.neighbours(work.goalBits()).andNot(work.wallBits());
+        packableCache.clear();
+        uint64_t all = goals.size() == 64 ? ~uint64_t(0) : (uint64_t(1) << goals.size()) - 1;
+        return packable(all);
+    }
+
+    // Bit i is set for each goals[i] that holds one of `boxes`; needs planPacking().
+    uint64_t filledGoals(const uint16_t* boxes) const {
+        uint64_t filled = 0;
+        for (int k = 0; k < boxCount; k++) {
+            if (goalIndex[boxes[k]] >= 0) {
+                filled |= uint64_t(1) << goalIndex[boxes[k]];
+            }
+        }
+        return filled;
+    }
+
+    // True if boxes on the `filled` goals, and nowhere else, can be pulled off them one at a
+    // time onto cells boxes arrive on, the player coming from outside: then those goals can
+    // be filled in the reverse order. Pulling a box off only frees the others, so taking off
+    // any box that can go is as good as any other order. Needs no boxes placed; cached.
+    bool packable(uint64_t filled) {
+        auto cached = packableCache.find(filled);
+        if (cached != packableCache.end()) {
+            return cached->second;
+        }
+        std::vector<uint16_t> left;
+        for (uint64_t bits = filled; bits; bits &= bits - 1) {
+            left.push_back(uint16_t(goals[__builtin_ctzll(bits)]));
+        }
+        bool unpacked = true;
+        while (!left.empty() && unpacked) {
+            placeBoxes(left.data(), int(left.size()), true);
+            int off = -1;
+            for (int k = 0; k < int(left.size()) && off < 0; k++) {
+                if (pullableOffGoals(left[k])) {
+                    off = k;
+                }
+            }
+            placeBoxes(left.data(), int(left.size()), false);
+            if (off < 0) {
+                unpacked = false;
+            } else {
+                left.erase(left.begin() + off);
+            }
+        }
+        packableCache.emplace(filled, unpacked);
+        return unpacked;
+    }
+
+    int goalAt(int cell) const { return goalIndex[cell]; }
+
+    // True for goals and the floor next to them, where goal macros start.
+    bool inPackingZone(int cell) const { return packingZone.test(cell); }
+
+    // The shortest pushes that take the box on `box` to each goal in `targets` (bits as in
+    // filledGoals()) it can reach with every other box left in place, the player starting
+    // anywhere `player` can reach, searched breadth-first over up to BOX_PATH_LIMIT
+    // positions. Appends one path per goal reached; needs the boxes placed and leaves them so.
+    void boxPaths(int box, int player, uint64_t targets, std::vector<std::vector<Push>>& paths) {
+        struct Step {
+            uint16_t box;
+            uint16_t player;
+            uint32_t parent;
+            uint8_t dir;
+        };
+        std::vector<Step> steps(1, Step{ uint16_t(box), uint16_t(player), UINT32_MAX, 0 });
+        std::unordered_set<uint32_t> seen;
+        seen.insert(uint32_t(box) << 16 | uint32_t(player));
+        std::vector<size_t> reached;
+        work.setBoxAt(box, false);
+        for (size_t next = 0; next < steps.size() && next < BOX_PATH_LIMIT && targets; next++) {
+            Step step = steps[next];
+            work.setBoxAt(step.box, true);
+            Reachability region = work.reachability(step.player, geometry);
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                int to = step.box + offsets[d];
+                if (!region.pushes[d].test(step.box) || work.isDeadAt(to)) {
+                    continue;
+                }
+                work.setBoxAt(step.box, false);
+                work.setBoxAt(to, true);
+                int moved = work.reachFrom(step.box, geometry).first();
+                work.setBoxAt(to, false);
+                work.setBoxAt(step.box, true);
+                if (seen.insert(uint32_t(to) << 16 | uint32_t(moved)).second) {
+                    steps.push_back({ uint16_t(to), uint16_t(moved), uint32_t(next), uint8_t(d) });
+                    uint64_t bit = goalIndex[to] >= 0 ? uint64_t(1) << goalIndex[to] : 0;
+                    if (targets & bit) {
+                        targets &= ~bit;
+                        reached.push_back(steps.size() - 1);
+                    }
+                }
+            }
+            work.setBoxAt(step.box, false);
+        }
+        work.setBoxAt(box, true);
+        for (size_t last : reached) {
+            paths.emplace_back();
+            for (size_t i = last; steps[i].parent != UINT32_MAX; i = steps[i].parent) {
+                paths.back().push_back({ steps[steps[i].parent].box, steps[i].dir });
+            }
+            std::reverse(paths.back().begin(), paths.back().end());
+        }
+    }
+
+    Board start;
+    Board work;
+    int boxCount;
+    int offsets[DIRECTION_COUNT];
+    uint16_t startPlayer;
+    std::vector<uint16_t> startBoxes;
+    std::vector<int> goals;
+    ZobristKeys keys;
+    TranspositionTable table;
+    MatchingHeuristic matching;
+
+private:
+    static const size_t TRAPPED_SEARCH_LIMIT = 256;
+    static const size_t CLUSTER_LIMIT = 6;
+    static const size_t CLUSTER_CACHE_LIMIT = size_t(1) << 20;
+    static const size_t BOX_PATH_LIMIT = 1024;
+
+    // True if the box on `goal` can be pulled onto a live cell off the goals that a box can
+    // arrive on, the player starting from `waiting`, with the boxes placed.
+    bool pullableOffGoals(int goal) {
+        std::vector<uint32_t> steps(1, uint32_t(goal) << 16 | uint32_t(work.reachFrom(waiting, geometry).first()));
+        std::unordered_set<uint32_t> seen(steps.begin(), steps.end());
+        work.setBoxAt(goal, false);
+        bool off = false;
+        for (size_t next = 0; next < steps.size() && next < BOX_PATH_LIMIT && !off; next++) {
+            int box = int(steps[next] >> 16);
+            work.setBoxAt(box, true);
+            Bitboard reached = work.reachFrom(int(steps[next] & 0xffff), geometry);
+            for (int d = 0; d < DIRECTION_COUNT && !off; d++) {
+                int to = box + offsets[d];
+                if (!reached.test(to) || !work.isFreeAt(to + offsets[d])) {
+                    continue;
+                }
+                if (!work.isGoalAt(to) && !work.isDeadAt(to) && arrivals[to]) {
+                    off = true;
+                    continue;
+                }
+                work.setBoxAt(box, false);
+                work.setBoxAt(to, true);
+                uint32_t step = uint32_t(to) << 16 | uint32_t(work.reachFrom(to + offsets[d], geometry).first());
+                work.setBoxAt(to, false);
+                work.setBoxAt(box, true);
+                if (seen.insert(step).second) {
+                    steps.push_back(step);
+                }
+            }
+            work.setBoxAt(box, false);
+        }
+        work.setBoxAt(goal, true);
+        return off;
+    }
+
+    // A corral is an area the player cannot reach, fenced off by boxes. It is a PI-corral if
+    // every legal push of its fence boxes goes into it (I) and the player can already stand
+    // behind every push into it that is not blocked by a wall (P). Until one of those pushes
+    // is made no push changes the corral, so if it holds a box off goal or an empty goal, some
+    // optimal solution makes one of them next: only they are kept, from the PI-corral with the
+    // fewest. If that PI-corral has no push into a live cell, the position is dead and no push
+    // is kept. Areas that touch a shared fence box are tried on their own and together.
+    void limitToCorral() {
+        Bitboard walls = work.wallBits();
+        Bitboard boxes = work.boxBits();
+        Bitboard unreached = geometry.inside.andNot(walls | boxes | region.cells);
+        areas.clear();
+        fences.clear();
+        while (!unreached.none()) {
+            Bitboard seed;
+            seed.clear();
+            seed.set(unreached.first());
+            Bitboard area = geometry.floodFill(seed, unreached);
+            unreached = unreached.andNot(area);
+            Bitboard fence = geometry.neighbours(area) & boxes;
+            if (fence.none()) {
+                continue;
+            }
+            if (corralDeadlock(area, fence, boxes)) {
+                for (int d = 0; d < DIRECTION_COUNT; d++) {
+                    region.pushes[d].clear();
+                }
+                return;
+            }
+            areas.push_back(area);
+            fences.push_back(fence);
+        }
+        if (areas.empty()) {
+            return;
+        }
+
+        Bitboard best[DIRECTION_COUNT];
+        int bestCount = -1;
+        auto consider = [&](const Bitboard& area, const Bitboard& fence) {
+            Bitboard allowed[DIRECTION_COUNT];
+            int count = 0;
+            if (!piCorral(area, fence, walls, boxes, allowed, count)) {
+                return;
+            }
+            if (bestCount < 0 || count < bestCount) {
+                bestCount = count;
+                std::copy(allowed, allowed + DIRECTION_COUNT, best);
+            }
+        };
+        for (size_t i = 0; i < areas.size() && bestCount != 0; i++) {
+            consider(areas[i], fences[i]);
+            // Everything that shares a fence box with area i, transitively.
+            Bitboard area = areas[i];
+            Bitboard fence = fences[i];
+            bool joined = false;
+            for (bool grew = true; grew;) {
+                grew = false;
+                for (size_t j = i + 1; j < areas.size(); j++) {
+                    if (!(fences[j] & fence).none() && (areas[j] & area).none()) {
+                        area = area | areas[j];
+                        fence = fence | fences[j];
+                        grew = joined = true;
+                    }
+                }
+            }
+            if (joined && bestCount != 0) {
+                consider(area, fence);
+            }
+        }
+        if (bestCount >= 0) {
+            std::copy(best, best + DIRECTION_COUNT, region.pushes);
+        }
+    }
+
+    // True if `area` still needs a box or holds a goal, yet no box of its fence can ever be
+    // pushed onto a live cell without freezing there. Only the fence and the boxes touching it
+    // stay on the board, which can only make pushes easier, and the pushes of the boxes
+    // touching it are searched (see trapped()).
+    bool corralDeadlock(const Bitboard& area, const Bitboard& fence, const Bitboard& boxes) {
+        const Bitboard& goals = work.goalBits();
+        if ((area & goals).none() && fence.andNot(goals).none()) {
+            return false;
+        }
+        Bitboard kept = fence | (geometry.neighbours(fence) & boxes);
+        std::vector<uint16_t> others;
+        std::vector<uint16_t> movable;
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            for (uint64_t bits = boxes.words[w]; bits; bits &= bits - 1) {
+                int i = w * 64 + __builtin_ctzll(bits);
+                if (!kept.test(i)) {
+                    others.push_back(uint16_t(i));
+                } else if (!fence.test(i)) {
+                    movable.push_back(uint16_t(i));
+                }
+            }
+        }
+        placeBoxes(others.data(), int(others.size()), false);
+        placeBoxes(movable.data(), int(movable.size()), false);
+        bool dead = trapped(movable, region.canonical, [&](const std::vector<uint16_t>&, const Reachability& reached) {
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                Bitboard live = (reached.pushes[d] & fence).andNot(geometry.step(deadBits, -DIR_DX[d], -DIR_DY[d]));
+                for (int w = 0; w < BITBOARD_WORDS; w++) {
+                    for (uint64_t bits = live.words[w]; bits; bits &= bits - 1) {
+                        int from = w * 64 + __builtin_ctzll(bits);
+                        int to = from + offsets[d];
+                        work.setBoxAt(from, false);
+                        work.setBoxAt(to, true);
+                        bool stuck = frozen(to);
+                        work.setBoxAt(to, false);
+                        work.setBoxAt(from, true);
+                        if (!stuck) {
+                            return true;
+                        }
+                    }
+                }
+            }
+            return false;
+        });
+        placeBoxes(movable.data(), int(movable.size()), true);
+        placeBoxes(others.data(), int(others.size()), true);
+        return dead;
+    }
+
+    // True if the boxes near the one just pushed to `cell`, the player standing at `player`,
+    // can never get onto goals or apart: that holds for them alone, with every other box off
+    // the board, which can only make pushes easier. A cluster is the pushed box and, in turn,
+    // every box within two cells of one already in it, up to CLUSTER_LIMIT boxes; its boxes
+    // are apart once no two touch, even diagonally. Results are cached by position.
+    bool clusterDeadlock(int cell, int player) {
+        if (!bitboards) {
+            return false;
+        }
+        Bitboard boxes = work.boxBits();
+        Bitboard cluster;
+        cluster.clear();
+        cluster.set(cell);
+        std::vector<uint16_t> members(1, uint16_t(cell));
+        int width = work.width();
+        for (size_t i = 0; i < members.size() && members.size() < CLUSTER_LIMIT; i++) {
+            for (int dy = -2; dy <= 2; dy++) {
+                for (int dx = -2; dx <= 2; dx++) {
+                    int x = members[i] % width + dx;
+                    int y = members[i] / width + dy;
+                    if (x < 0 || y < 0 || x >= width || y >= work.height()) {
+                        continue;
+                    }
+                    int j = y * width + x;
+                    if (boxes.test(j) && !cluster.test(j) && members.size() < CLUSTER_LIMIT) {
+                        cluster.set(j);
+                        members.push_back(uint16_t(j));
+                    }
+                }
+            }
+        }
+        std::sort(members.begin(), members.end());
+        if (members.size() < 2 || apart(members)) {
+            return false;
+        }
+
+        Bitboard others = boxes.andNot(cluster);
+        setBoxes(others, false);
+        int canonical = work.reachFrom(player, geometry).first();
+        placeBoxes(members.data(), int(members.size()), false);
+        uint64_t key = keys.boxes(members.data(), int(members.size())) ^ keys.player(canonical);
+        auto cached = clusterCache.find(key);
+        bool dead;
+        if (cached != clusterCache.end()) {
+            dead = cached->second;
+        } else {
+            dead = trapped(members, canonical,
+                           [&](const std::vector<uint16_t>& current, const Reachability&) { return apart(current); });
+            if (clusterCache.size() >= CLUSTER_CACHE_LIMIT) {
+                clusterCache.clear();
+            }
+            clusterCache.emplace(key, dead);
+        }
+        placeBoxes(members.data(), int(members.size()), true);
+        setBoxes(others, true);
+        return dead;
+    }
+
+    // True if every box in `cells` is on a goal or touches no other, even diagonally.
+    bool apart(const std::vector<uint16_t>& cells) const {
+        int width = work.width();
+        bool onGoals = true;
+        bool separate = true;
+        for (size_t i = 0; i < cells.size(); i++) {
+            onGoals = onGoals && work.isGoalAt(cells[i]);
+            for (size_t j = i + 1; j < cells.size() && separate; j++) {
+                separate = std::abs(cells[i] % width - cells[j] % width) > 1 ||
+                           std::abs(cells[i] / width - cells[j] / width) > 1;
+            }
+        }
+        return onGoals || separate;
+    }
+
+    // Searches the pushes of the boxes in `movable` (ascending, not placed; the boxes placed
+    // stay still) breadth-first from the player at `player`, and returns true if no position
+    // found satisfies `escaped(boxes, reachability)`. Running out of positions after
+    // TRAPPED_SEARCH_LIMIT returns false, as does a position that escapes.
+    template <typename Escaped>
+    bool trapped(const std::vector<uint16_t>& movable, int player, Escaped escaped) {
+        int m = int(movable.size());
+        std::vector<uint16_t> states(movable);  // m boxes per position, in search order
+        std::vector<uint16_t> players(1, uint16_t(player));
+        std::unordered_set<uint64_t> seen;
+        seen.insert(keys.boxes(movable.data(), m) ^ keys.player(player));
+        bool dead = true;
+        std::vector<uint16_t> current(m);
+        for (size_t next = 0; next < players.size() && dead; next++) {
+            if (next == TRAPPED_SEARCH_LIMIT) {
+                dead = false;
+                break;
+            }
+            std::copy(states.begin() + next * m, states.begin() + (next + 1) * m, current.begin());
+            placeBoxes(current.data(), m, true);
+            Reachability reached = work.reachability(players[next], geometry);
+            dead = !escaped(current, reached);
+            for (int k = 0; k < m && dead; k++) {
+                int from = current[k];
+                for (int d = 0; d < DIRECTION_COUNT; d++) {
+                    int to = from + offsets[d];
+                    if (!reached.pushes[d].test(from) || work.isDeadAt(to)) {
+                        continue;
+                    }
+                    work.setBoxAt(from, false);
+                    work.setBoxAt(to, true);
+                    if (!frozen(to)) {
+                        std::vector<uint16_t> child(current);
+                        moveBox(child.data(), m, k, to);
+                        int moved = work.reachFrom(from, geometry).first();
+                        if (seen.insert(keys.boxes(child.data(), m) ^ keys.player(moved)).second) {
+                            states.insert(states.end(), child.begin(), child.end());
+                            players.push_back(uint16_t(moved));
+                        }
+                    }
+                    work.setBoxAt(to, false);
+                    work.setBoxAt(from, true);
+                }
+            }
+            placeBoxes(current.data(), m, false);
+        }
+        return dead;
+    }
+
+    void setBoxes(const Bitboard& cells, bool on) {
+        for (int w = 0; w < BITBOARD_WORDS; w++) {
+            for (uint64_t bits = cells.words[w]; bits; bits &= bits - 1) {
+                work.setBoxAt(w * 64 + __builtin_ctzll(bits), on);
+            }
+        }
+    }
+
+    void placeBoxes(const uint16_t* cells, int count, bool on) {
+        for (int k = 0; k < count; k++) {
+            work.setBoxAt(cells[k], on);
+        }
+    }
+
+    // Checks the PI conditions for `area` fenced by `fence`; on success fills `allowed` with
+    // the pushes into it per direction and `count` with those onto live cells.
+    bool piCorral(const Bitboard& area, const Bitboard& fence, const Bitboard& walls, const Bitboard& boxes,
+                  Bitboard allowed[DIRECTION_COUNT], int& count) const {
+        const Bitboard& goals = work.goalBits();
+        if ((area & goals).none() && fence.andNot(goals).none()) {
+            return false;  // nothing left to do in it
+        }
+        Bitboard outside = geometry.inside.andNot(walls | boxes | area | deadBits);
+        count = 0;
+        for (int d = 0; d < DIRECTION_COUNT; d++) {
+            int dx = DIR_DX[d];
+            int dy = DIR_DY[d];
+            Bitboard playerBehind = fence & geometry.step(region.cells, dx, dy);
+            if (!(playerBehind & geometry.step(outside, -dx, -dy)).none()) {
+                return false;  // I: a fence box can be pushed out of the corral
+            }
+            Bitboard inward = fence & geometry.step(area, -dx, -dy);
+            if (!inward.andNot(playerBehind | geometry.step(walls, dx, dy)).none()) {
+                return false;  // P: a push into the corral needs the player inside it
+            }
+            allowed[d] = inward & playerBehind;
+            count += allowed[d].andNot(geometry.step(deadBits, -dx, -dy)).count();
+        }
+        return true;
+    }
+
+    int floodFill(int from, std::vector<uint32_t>& marks, uint32_t mark) {
+        int head = 0;
+        int tail = 0;
+        int smallest = from;
+        queue[tail++] = from;
+        marks[from] = mark;
+        while (head < tail) {
+            int cell = queue[head++];
+            smallest = std::min(smallest, cell);
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                int next = cell + offsets[d];
+                if (marks[next] != mark && work.isFreeAt(next)) {
+                    marks[next] = mark;
+                    queue[tail++] = next;
+                }
+            }
+        }
+        return smallest;
+    }
+
+    BitboardGeometry geometry;
+    bool bitboards;
+    Reachability region;
+    Bitboard deadBits;
+    Bitboard packingZone;          // goals and their floor neighbours, see planPacking()
+    int waiting;                   // where the player waits while boxes are pulled off goals
+    std::vector<uint8_t> arrivals;  // cells a box can be pushed onto from its start
+    std::vector<int> goalIndex;    // index in `goals` of each goal cell, -1 elsewhere
+    std::unordered_map<uint64_t, bool> packableCache;  // packable() results by filled goals
+    std::unordered_map<uint64_t, bool> clusterCache;  // clusterDeadlock() results by position
+    std::vector<Bitboard> areas;   // limitToCorral() scratch: unreached areas with a fence
+    std::vector<Bitboard> fences;
+    std::vector<uint32_t> visit;
+    std::vector<uint32_t> childVisit;
+    uint32_t stamp;
+    uint32_t childStamp;
+    std::vector<int> queue;
+};
+
+
+std::string solutionMoves(SearchSpace& space, const std::vector<Push>& pushes) {
+    std::string moves;
+    space.placeBoxes(space.startBoxes.data(), true);
+    int player = space.startPlayer;
+    for (const Push& push : pushes) {
+        int offset = space.offsets[push.dir];
+        moves += space.walk(player, push.from - offset);
+        moves += DIR_PUSH_CHAR[push.dir];
+        space.work.setBoxAt(push.from, false);
+        space.work.setBoxAt(push.from + offset, true);
+        player = push.from;
+    }
+    for (int i = 0; i < space.work.size(); i++) {
+        space.work.setBoxAt(i, false);
+    }
+    return moves;
+}
+
+
+// Replays a move string through Board::movePlayer, the same rules the game uses.
+bool verifySolution(const Board& board, const std::string& moves) {
+    Board replay = board;
+    for (char c : moves) {
+        int dir = int(std::find(DIR_MOVE_CHAR, DIR_MOVE_CHAR + DIRECTION_COUNT, char(tolower(c))) - DIR_MOVE_CHAR);
+        if (dir == DIRECTION_COUNT) {
+            return false;
+        }
+        bool pushed = false;
+        if (!replay.movePlayer(DIR_DX[dir], DIR_DY[dir], &pushed) || pushed != (c == DIR_PUSH_CHAR[dir])) {
+            return false;
+        }
+    }
+    return replay.isSolved();
+}
+
+
+// Breadth-first search over pulls from every position with all boxes on goals. A pull is a
+// push played backwards: the player steps away from a box and drags it onto the cell the
+// player left. Every state it stores is at its exact distance in pushes from a solved
+// position, and every state it has not stored is at least completeDepth() + 1 pushes away, so
+// SOLVER_BIDIRECTIONAL grows it first and lets A* finish on meeting it.
+class PullSearch {
+public:
+    static const uint32_t NO_STATE = UINT32_MAX;
+
+    PullSearch(SearchSpace& space, const SolverOptions& options, SolverStats& stats)
+        : space(space), options(options), stats(stats), n(space.boxCount) {}
+
+    // Pulls until `budget` states have been expanded, the state `stop` (a box hash with its
+    // canonical player folded in) is reached or no state is left. Returns false if the time
+    // or memory limit ended it, with stats.limit set.
+    bool grow(uint64_t budget, uint64_t stop, Clock::time_point started) {
+        std::vector<uint16_t> solved(space.goals.begin(), space.goals.end());
+        std::sort(solved.begin(), solved.end());
+        uint64_t boxHash = space.keys.boxes(solved.data(), n);
+        space.placeBoxes(solved.data(), true);
+        std::vector<bool> seen(space.work.size(), false);
+        for (int i = 0; i < space.work.size(); i++) {
+            if (seen[i] || !space.work.isFreeAt(i)) {
+                continue;
+            }
+            // One start state per area the player can be in, named by its smallest cell.
+            int canonical = space.reach(i);
+            for (int j = i; j < space.work.size(); j++) {
+                seen[j] = seen[j] || space.reachable(j);
+            }
+            addNode(NO_STATE, solved.data(), boxHash, canonical, 0, 0);
+        }
+        space.placeBoxes(solved.data(), false);
+
+        std::vector<uint16_t> current(n);
+        std::vector<uint16_t> child(n);
+        for (uint64_t expanded = 0; expanded < budget && next < nodes.size() && find(stop) == NO_STATE; expanded++) {
+            if (options.timeLimit > 0 && (stats.expanded & 4095) == 0 &&
+                std::chrono::duration<double>(Clock::now() - started).count() > options.timeLimit) {
+                stats.limit = LIMIT_TIME;
+                return false;
+            }
+            stats.memoryBytes = std::max(stats.memoryBytes, memoryBytes());
+            if (options.memoryLimit > 0 && stats.memoryBytes > options.memoryLimit) {
+                stats.limit = LIMIT_MEMORY;
+                return false;
+            }
+            stats.expanded++;
+            expand(uint32_t(next++), current, child);
+        }
+        // Only expansion needs the boxes; the forward search gets the memory back.
+        std::vector<uint16_t>().swap(boxPool);
+        return true;
+    }
+
+    // The stored state with key `key`, or NO_STATE.
+    uint32_t find(uint64_t key) const {
+        auto found = visits.find(key);
+        return found == visits.end() ? NO_STATE : found->second;
+    }
+
+    int depth(uint32_t index) const { return nodes[index].depth; }
+
+    // Every state at most this many pulls from a solved position is stored.
+    int completeDepth() const {
+        return next < nodes.size() ? nodes[next].depth : (nodes.empty() ? 0 : nodes.back().depth + 1);
+    }
+
+    // Appends the pushes that undo the pulls leading to state `index`, which take it to a
+    // solved position.
+    void appendPushes(uint32_t index, std::vector<Push>& pushes) const {
+        for (uint32_t i = index; nodes[i].parent != NO_STATE; i = nodes[i].parent) {
+            pushes.push_back({ nodes[i].from, nodes[i].dir });
+        }
+    }
+
+    // Nodes and boxes plus the map, counting a bucket pointer and one heap node per entry as a
+    // typical std::unordered_map does.
+    size_t memoryBytes() const {
+        return visits.bucket_count() * sizeof(void*) +
+               visits.size() * (sizeof(std::pair<const uint64_t, uint32_t>) + 2 * sizeof(void*)) +
+               nodes.capacity() * sizeof(Node) + boxPool.capacity() * sizeof(uint16_t);
+    }
+
+private:
+    struct Node {
+        uint64_t boxHash;
+        uint32_t parent;
+        uint16_t player;
+        uint16_t from;  // box cell after the pull, where the undoing push starts
+        uint16_t depth;
+        uint8_t dir;
+    };
+
+    void addNode(uint32_t parent, const uint16_t* boxes, uint64_t boxHash, int player, int from, int dir) {
+        auto inserted = visits.insert({ boxHash ^ space.keys.player(player), uint32_t(nodes.size()) });
+        if (!inserted.second) {
+            stats.duplicates++;
+            return;
+        }
+        uint16_t depth = parent == NO_STATE ? 0 : uint16_t(nodes[parent].depth + 1);
+        nodes.push_back({ boxHash, parent, uint16_t(player), uint16_t(from), depth, uint8_t(dir) });
+        boxPool.insert(boxPool.end(), boxes, boxes + n);
+        stats.meeting.backwardStates++;
+    }
+
+    // Pulling the box at `box` in direction d: the player stands at box - offset, steps to
+    // box - 2 * offset and the box follows onto box - offset. The forward push that undoes it
+    // moves the box from box - offset in direction d.
+    void expand(uint32_t index, std::vector<uint16_t>& current, std::vector<uint16_t>& child) {
+        Node node = nodes[index];
+        std::copy(boxPool.data() + size_t(index) * n, boxPool.data() + size_t(index + 1) * n, current.begin());
+        space.placeBoxes(current.data(), true);
+        space.reach(node.player);
+        for (int k = 0; k < n; k++) {
+            int box = current[k];
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                int offset = space.offsets[d];
+                int to = box - offset;
+                if (!space.reachable(to) || !space.work.isFreeAt(to - offset) || space.work.isDeadAt(to)) {
+                    continue;
+                }
+                stats.generated++;
+                space.work.setBoxAt(box, false);
+                space.work.setBoxAt(to, true);
+                int childPlayer = space.normalize(to - offset);
+                space.work.setBoxAt(to, false);
+                space.work.setBoxAt(box, true);
+                std::copy(current.begin(), current.end(), child.begin());
+                moveBox(child.data(), n, k, to);
+                addNode(index, child.data(), space.keys.push(node.boxHash, box, to), childPlayer, to, d);
+            }
+        }
+        space.placeBoxes(current.data(), false);
+    }
+
+    SearchSpace& space;
+    const SolverOptions& options;
+    SolverStats& stats;
+    int n;
+    std::vector<Node> nodes;  // in pull order, so depths never decrease
+    std::vector<uint16_t> boxPool;
+    size_t next = 0;          // first node not expanded yet
+    std::unordered_map<uint64_t, uint32_t> visits;
+};
+
+
+// With a `perimeter` of pulled states, a state found in it is bounded by its exact distance
+// and any other by more than the perimeter's complete depth, and popping a state from it ends
+// the search: its pushes plus the ones undoing its pulls are optimal.
+class AStarSearch {
+public:
+    AStarSearch(SearchSpace& space, const SolverOptions& options, SolverStats& stats,
+                const PullSearch* perimeter = nullptr)
+        : space(space), options(options), stats(stats), n(space.boxCount), perimeter(perimeter), macroBytes(0) {}
+
+    bool run(std::vector<Push>& pushes) {
+        Clock::time_point started = Clock::now();
+        int h = space.heuristic(space.startBoxes.data());
+        if (h == NO_SOLUTION) {
+            return false;
+        }
+        // The table is the closed set: an evicted state would be searched again.
+        space.table.setExact(true);
+        bool macros = options.goalMacros && space.planPacking();
+        space.placeBoxes(space.startBoxes.data(), true);
+        int player = space.reach(space.startPlayer);
+        space.placeBoxes(space.startBoxes.data(), false);
+        addNode(UINT32_MAX, space.startBoxes.data(), space.keys.boxes(space.startBoxes.data(), n), player, 0, 0, 0, h);
+
+        std::vector<uint16_t> current(n);
+        std::vector<uint16_t> child(n);
+        while (!open.empty()) {
+            uint32_t index = uint32_t(open.top() & 0xffffffff);
+            open.pop();
+            if (nodes[index].stale) {
+                continue;
+            }
+            uint32_t meeting = perimeter ? perimeter->find(nodes[index].boxHash ^ space.keys.player(nodes[index].player))
+                                         : PullSearch::NO_STATE;
+            if (nodes[index].h == 0 || meeting != PullSearch::NO_STATE) {
+                for (uint32_t i = index; nodes[i].parent != UINT32_MAX; i = nodes[i].parent) {
+                    auto macro = macroPushes.find(i);
+                    if (macro != macroPushes.end()) {
+                        pushes.insert(pushes.end(), macro->second.rbegin(), macro->second.rend());
+                    } else {
+                        pushes.push_back({ nodes[i].pushFrom, nodes[i].pushDir });
+                    }
+                }
+                std::reverse(pushes.begin(), pushes.end());
+                if (meeting != PullSearch::NO_STATE) {
+                    perimeter->appendPushes(meeting, pushes);
+                    stats.meeting.forwardDepth = nodes[index].g;
+                    stats.meeting.backwardDepth = perimeter->depth(meeting);
+                }
+                return true;
+            }
+            if (getenv("DUMP") && nodes[index].h < dumpBest) { dumpBest = nodes[index].h; dumpIndex = index; }
+            if (stats.expanded >= options.maxNodes) {
+                stats.limit = LIMIT_NODES;
+                if (getenv("DUMP")) { Board b = space.work; for (int i=0;i<n;i++) b.setBoxAt(boxesOf(dumpIndex)[i], true); std::cerr << "macros=" << macroPushes.size() << " h=" << dumpBest << " g=" << nodes[dumpIndex].g << " player " << nodes[dumpIndex].player << "\n"; for (int y=0;y<b.height();y++){for(int x=0;x<b.width();x++){int i=y*b.width()+x; std::cerr << (b.isWallAt(i)?'#':b.hasBoxAt(i)?(b.isGoalAt(i)?'*':'$'):b.isGoalAt(i)?'.':b.isDeadAt(i)?'x':' ');} std::cerr << "\n";} }
+                return false;
+            }
+            if (options.timeLimit > 0 && (stats.expanded & 4095) == 0 &&
+                std::chrono::duration<double>(Clock::now() - started).count() > options.timeLimit) {
+                stats.limit = LIMIT_TIME;
+                return false;
+            }
+            stats.memoryBytes = std::max(stats.memoryBytes, memoryBytes());
+            if (options.memoryLimit > 0 && stats.memoryBytes > options.memoryLimit) {
+                stats.limit = LIMIT_MEMORY;
+                return false;
+            }
+            stats.expanded++;
+
+            Node node = nodes[index];
+            std::copy(boxesOf(index), boxesOf(index) + n, current.begin());
+            space.prepareChildren(current.data());
+            // Boxes on goals that could have been packed in some order stay there, and only
+            // goal macros fill goals: those that keep the filled goals packable.
+            bool packed = false;
+            uint64_t targets = 0;
+            if (macros) {
+                uint64_t filled = space.filledGoals(current.data());
+                packed = space.packable(filled);
+                for (int i = 0; i < int(space.goals.size()) && packed; i++) {
+                    uint64_t bit = uint64_t(1) << i;
+                    if (!(filled & bit) && space.packable(filled | bit)) {
+                        targets |= bit;
+                    }
+                }
+            }
+            space.placeBoxes(current.data(), true);
+            space.reach(node.player);
+            bool cut = targets && addGoalMacros(index, node, current, child, targets, packed);
+            for (int k = 0; k < n && !cut; k++) {
+                int from = current[k];
+                if (packed && space.work.isGoalAt(from)) {
+                    continue;
+                }
+                for (int d = 0; d < DIRECTION_COUNT; d++) {
+                    int to = from + space.offsets[d];
+                    if (!space.canPush(from, d) || space.work.isDeadAt(to) || (macros && space.work.isGoalAt(to))) {
+                        continue;
+                    }
+                    stats.generated++;
+                    space.work.setBoxAt(from, false);
+                    space.work.setBoxAt(to, true);
+                    bool deadlocked = space.deadlocked(to, from);
+                    int childPlayer = deadlocked ? 0 : space.normalize(from);
+                    space.work.setBoxAt(to, false);
+                    space.work.setBoxAt(from, true);
+                    if (deadlocked) {
+                        stats.deadlocks++;
+                        continue;
+                    }
+                    std::copy(current.begin(), current.end(), child.begin());
+                    moveBox(child.data(), n, k, to);
+                    int childH = space.childHeuristic(child.data(), k, to);
+                    if (childH == NO_SOLUTION) {
+                        continue;
+                    }
+                    addNode(index, child.data(), space.keys.push(node.boxHash, from, to), childPlayer, from, d,
+                            node.g + 1, childH);
+                }
+            }
+            space.placeBoxes(current.data(), false);
+        }
+        return false;
+    }
+
+private:
+    struct Node {
+        uint64_t boxHash;
+        uint32_t parent;
+        uint16_t player;
+        uint16_t pushFrom;
+        uint16_t g;
+        uint16_t h;
+        uint8_t pushDir;
+        bool stale;
+    };
+
+    const uint16_t* boxesOf(uint32_t index) const { return boxPool.data() + size_t(index) * n; }
+
+    // What the search holds: the table, every node with its boxes, the open list, the goal
+    // macros and the perimeter, if any.
+    size_t memoryBytes() const {
+        return space.table.memoryBytes() + nodes.capacity() * sizeof(Node) + boxPool.capacity() * sizeof(uint16_t) +
+               open.size() * sizeof(uint64_t) + macroBytes + (perimeter ? perimeter->memoryBytes() : 0);
+    }
+
+    // Adds a child for every box in the packing zone, and not already packed, and every goal
+    // in `targets` it can be pushed to without moving another box. Returns true if there is
+    // one: these children then replace the node's single pushes (a goal cut). Expects the
+    // node's boxes placed and the matching prepared for its children.
+    bool addGoalMacros(uint32_t index, const Node& node, const std::vector<uint16_t>& current,
+                       std::vector<uint16_t>& child, uint64_t targets, bool packed) {
+        bool found = false;
+        std::vector<std::vector<Push>> paths;
+        for (int k = 0; k < n; k++) {
+            int from = current[k];
+            if (!space.inPackingZone(from) || (packed && space.work.isGoalAt(from))) {
+                continue;
+            }
+            paths.clear();
+            space.boxPaths(from, node.player, targets, paths);
+            for (std::vector<Push>& path : paths) {
+                found = true;
+                stats.generated++;
+                int target = path.back().from + space.offsets[path.back().dir];
+                space.work.setBoxAt(from, false);
+                space.work.setBoxAt(target, true);
+                bool deadlocked = space.deadlocked(target, path.back().from);
+                int childPlayer = deadlocked ? 0 : space.normalize(path.back().from);
+                space.work.setBoxAt(target, false);
+                space.work.setBoxAt(from, true);
+                if (deadlocked) {
+                    stats.deadlocks++;
+                    continue;
+                }
+                std::copy(current.begin(), current.end(), child.begin());
+                moveBox(child.data(), n, k, target);
+                int childH = space.childHeuristic(child.data(), k, target);
+                if (childH == NO_SOLUTION) {
+                    continue;
+                }
+                uint32_t added = addNode(index, child.data(), space.keys.push(node.boxHash, from, target), childPlayer,
+                                         path.back().from, path.back().dir, node.g + int(path.size()), childH);
+                if (added != UINT32_MAX) {
+                    macroBytes += path.size() * sizeof(Push) + sizeof(path);
+                    macroPushes[added] = std::move(path);
+                }
+            }
+        }
+        return found;
+    }
+
+    // Returns the new node's index, or UINT32_MAX if the state was already reached as cheaply.
+    uint32_t addNode(uint32_t parent, const uint16_t* boxes, uint64_t boxHash, int player, int pushFrom, int pushDir,
+                     int g, int h) {
+        uint64_t key = boxHash ^ space.keys.player(player);
+        bool found = false;
+        TranspositionEntry* entry = space.table.probe(key, found);
+        if (found) {
+            if (entry->g <= g) {
+                stats.duplicates++;
+                return UINT32_MAX;
+            }
+            nodes[entry->value].stale = true;
+        }
+        if (perimeter) {
+            uint32_t meeting = perimeter->find(key);
+            if (meeting != PullSearch::NO_STATE) {
+                stats.meeting.meetings++;
+                h = perimeter->depth(meeting);
+            } else {
+                h = std::max(h, perimeter->completeDepth() + 1);
+            }
+            stats.meeting.forwardStates++;
+        }
+
+        uint32_t index = uint32_t(nodes.size());
+        nodes.push_back({ boxHash, parent, uint16_t(player), uint16_t(pushFrom), uint16_t(g), uint16_t(h),
+                          uint8_t(pushDir), false });
+        boxPool.insert(boxPool.end(), boxes, boxes + n);
+        entry->value = index;
+        entry->g = uint16_t(g);
+
+        // Lowest f first; among equal f prefer the deeper node.
+        static int W = getenv("W") ? atoi(getenv("W")) : 1;
+        uint64_t f = uint64_t(g + W * h);
+        open.push((f << 48) | (uint64_t(0xffff - g) << 32) | index);
+        return index;
+    }
+
+    SearchSpace& space;
+    const SolverOptions& options;
+    SolverStats& stats;
+    int n;
+    const PullSearch* perimeter;
+    std::vector<Node> nodes;
+    std::vector<uint16_t> boxPool;
+    std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> open;
+    std::unordered_map<uint32_t, std::vector<Push>> macroPushes;  // goal macro nodes' pushes, by node
+    size_t macroBytes;
+    int dumpBest = 1 << 30; uint32_t dumpIndex = 0;
+};
+
+
+class IdaStarSearch {
+public:
+    IdaStarSearch(SearchSpace& space, const SolverOptions& options, SolverStats& stats)
+        : space(space), options(options), stats(stats), n(space.boxCount), aborted(false) {}
+
+    bool run(std::vector<Push>& pushes) {
+        started = Clock::now();
+        std::vector<uint16_t> boxes = space.startBoxes;
+        int h = space.heuristic(boxes.data());
+        if (h == NO_SOLUTION) {
+            return false;
+        }
+        space.placeBoxes(boxes.data(), true);
+        int player = space.reach(space.startPlayer);
+        space.placeBoxes(boxes.data(), false);
+
+        // The table is all the memory IDA* needs besides the current path.
+        stats.memoryBytes = space.table.memoryBytes();
+        if (options.memoryLimit > 0 && stats.memoryBytes > options.memoryLimit) {
+            stats.limit = LIMIT_MEMORY;
+            return false;
+        }
+
+        uint64_t boxHash = space.keys.boxes(boxes.data(), n);
+        int threshold = h;
+        while (!aborted) {
+            next = NO_SOLUTION;
+            space.table.newGeneration();
+            if (search(boxes, boxHash, player, 0, h, threshold)) {
+                pushes = path;
+                return true;
+            }
+            if (next == NO_SOLUTION) {
+                return false;
+            }
+            threshold = next;
+        }
+        return false;
+    }
+
+private:
+    bool search(std::vector<uint16_t>& boxes, uint64_t boxHash, int player, int g, int h, int threshold) {
+        if (g + h > threshold) {
+            next = std::min(next, g + h);
+            return false;
+        }
+        if (h == 0) {
+            return true;
+        }
+        if (stats.expanded >= options.maxNodes) {
+            stats.limit = LIMIT_NODES;
+            aborted = true;
+            return false;
+        }
+        if (options.timeLimit > 0 && (stats.expanded & 4095) == 0 &&
+            std::chrono::duration<double>(Clock::now() - started).count() > options.timeLimit) {
+            stats.limit = LIMIT_TIME;
+            aborted = true;
+            return false;
+        }
+        stats.expanded++;
+
+        // A state already searched this iteration from no deeper a g cannot lead anywhere new;
+        // this also cuts cycles, since states on the current path are stored with a smaller g.
+        bool seen = false;
+        TranspositionEntry* entry = space.table.probe(boxHash ^ space.keys.player(player), seen);
+        if (seen && entry->generation == space.table.generation() && entry->g <= g) {
+            stats.duplicates++;
+            return false;
+        }
+        entry->g = uint16_t(g);
+        entry->generation = space.table.generation();
+
+        struct Successor {
+            int k;
+            int dir;
+            int player;
+        };
+        std::vector<Successor> successors;
+        space.placeBoxes(boxes.data(), true);
+        space.reach(player);
+        for (int k = 0; k < n; k++) {
+            int from = boxes[k];
+            for (int d = 0; d < DIRECTION_COUNT; d++) {
+                int to = from + space.offsets[d];
+                if (!space.canPush(from, d) || space.work.isDeadAt(to)) {
+                    continue;
+                }
+                space.work.setBoxAt(from, false);
+                space.work.setBoxAt(to, true);
+                if (space.deadlocked(to, from)) {
+                    stats.deadlocks++;
+                } else {
+                    successors.push_back({ k, d, space.normalize(from) });
+                }
+                space.work.setBoxAt(to, false);
+                space.work.setBoxAt(from, true);
+            }
+        }
+        space.placeBoxes(boxes.data(), false);
+
+        // Bound every child before recursing, while the matching kept for `boxes` is current.
+        std::vector<int> childH(successors.size());
+        space.prepareChildren(boxes.data());
+        for (size_t i = 0; i < successors.size(); i++) {
+            std::vector<uint16_t> child = boxes;
+            int to = boxes[successors[i].k] + space.offsets[successors[i].dir];
+            moveBox(child.data(), n, successors[i].k, to);
+            childH[i] = space.childHeuristic(child.data(), successors[i].k, to);
+        }
+
+        bool found = false;
+        for (size_t i = 0; i < successors.size(); i++) {
+            const Successor& successor = successors[i];
+            stats.generated++;
+            std::vector<uint16_t> child = boxes;
+            int from = boxes[successor.k];
+            moveBox(child.data(), n, successor.k, from + space.offsets[successor.dir]);
+            if (childH[i] == NO_SOLUTION) {
+                continue;
+            }
+            int to = from + space.offsets[successor.dir];
+            path.push_back({ from, successor.dir });
+            if (search(child, space.keys.push(boxHash, from, to), successor.player, g + 1, childH[i], threshold)) {
+                found = true;
+                break;
+            }
+            path.pop_back();
+            if (aborted) {
+                break;
+            }
+        }
+        return found;
+    }
+
+    SearchSpace& space;
+    const SolverOptions& options;
+    SolverStats& stats;
+    int n;
+    bool aborted;
+    int next;
+    Clock::time_point started;
+    std::vector<Push> path;
+};
+
+
+// Hash-distributed A* (HDA*): every state has an owner thread chosen by its Zobrist key, and
+// only the owner stores, deduplicates and expands it. Successors owned by another thread are
+// batched and sent to that thread's lock-free mailbox. Threads expand in their own best-first
+// order, so a solution found first need not be optimal; it becomes the incumbent, nodes with
+// f >= incumbent are pruned, and the search ends when no thread holds or is being sent a node
+// that could improve on it. With the admissible heuristic the incumbent is then optimal.
+class HdaStarSearch {
+public:
+    HdaStarSearch(const Board& board, const SolverOptions& options, SolverStats& stats, size_t tableBytes,
+                  const PushDistanceTable* pushes)
+        : options(options), stats(stats), threadCount(std::max(1, options.threads)), incumbent(NO_SOLUTION),
+          outstanding(0), expandedTotal(0), stop(false) {
+        // The push distance table is read-only and shared; everything else is per thread.
+        for (int t = 0; t < threadCount; t++) {
+            workers.push_back(std::unique_ptr<Worker>(new Worker(board, tableBytes / threadCount, options.heuristic, pushes,
+                                                                 threadCount)));
+            workers.back()->space.table.setExact(true);
+        }
+        n = workers[0]->space.boxCount;
+    }
+
+    ~HdaStarSearch() {
+        for (auto& worker : workers) {
+            while (StateBatch* batch = worker->inbox.receive()) {
+                delete batch;
+            }
+        }
+    }
+
+    bool run(std::vector<Push>& pushes) {
+        started = Clock::now();
+        SearchSpace& space = workers[0]->space;
+        int h = space.heuristic(space.startBoxes.data());
+        if (h == NO_SOLUTION) {
+            return false;
+        }
+        space.placeBoxes(space.startBoxes.data(), true);
+        int player = space.reach(space.startPlayer);
+        space.placeBoxes(space.startBoxes.data(), false);
+        if (h == 0) {
+            return true;
+        }
+        uint64_t boxHash = space.keys.boxes(space.startBoxes.data(), n);
+        Worker& owner = *workers[ownerOf(boxHash ^ space.keys.player(player))];
+        outstanding = 1;
+        addNode(owner, { boxHash, NO_PARENT, 0, uint16_t(player), 0, 0, uint16_t(h), 0 }, space.startBoxes.data());
+
+        std::vector<std::thread> threads;
+        for (int t = 1; t < threadCount; t++) {
+            threads.emplace_back(&HdaStarSearch::work, this, t);
+        }
+        work(0);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        for (auto& worker : workers) {
+            stats.expanded += worker->stats.expanded;
+            stats.generated += worker->stats.generated;
+            stats.duplicates += worker->stats.duplicates;
+            stats.deadlocks += worker->stats.deadlocks;
+            stats.memoryBytes += worker->stats.memoryBytes;
+            const TranspositionStats& table = worker->space.table.stats();
+            stats.table.probes += table.probes;
+            stats.table.hits += table.hits;
+            stats.table.stores += table.stores;
+            stats.table.collisions += table.collisions;
+            stats.table.evictions += table.evictions;
+            stats.table.resizes += table.resizes;
+            if (worker->stats.limit != LIMIT_NONE) {
+                stats.limit = worker->stats.limit;
+            }
+        }
+        if (stats.limit != LIMIT_NONE || incumbent.load() == NO_SOLUTION) {
+            return false;
+        }
+        for (Location at = solution; at.index != NO_PARENT;) {
+            const State& node = workers[at.thread]->nodes[at.index].state;
+            if (node.parent == NO_PARENT) {
+                break;
+            }
+            pushes.push_back({ node.pushFrom, node.pushDir });
+            at = { node.parentThread, node.parent };
+        }
+        std::reverse(pushes.begin(), pushes.end());
+        return true;
+    }
+
+    // The first worker's space; after run() it can rebuild the solution's moves.
+    SearchSpace& space() { return workers[0]->space; }
+
+private:
+    static const uint32_t NO_PARENT = UINT32_MAX;
+    static const size_t BATCH_STATES = 64;
+
+    // A state as it travels between threads; the boxes travel alongside.
+    struct State {
+        uint64_t boxHash;
+        uint32_t parent;
+        uint16_t parentThread;
+        uint16_t player;
+        uint16_t pushFrom;
+        uint16_t g;
+        uint16_t h;
+        uint8_t pushDir;
+    };
+
+    struct StateBatch : MailboxNode {
+        std::vector<State> states;
+        std::vector<uint16_t> boxes;
+    };
+
+    struct Node {
+        State state;
+        bool stale;
+    };
+
+    struct Location {
+        uint16_t thread;
+        uint32_t index;
+    };
+
+    struct Worker {
+        Worker(const Board& board, size_t tableBytes, HeuristicKind heuristic, const PushDistanceTable* pushes,
+               int threadCount)
+            : space(board, tableBytes, heuristic, pushes), outbox(threadCount) {}
+
+        SearchSpace space;
+        std::vector<Node> nodes;
+        std::vector<uint16_t> boxPool;
+        std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<uint64_t>> open;
+        Mailbox<StateBatch> inbox;
+        std::vector<std::unique_ptr<StateBatch>> outbox;  // per destination thread, not sent yet
+        SolverStats stats;
+    };
+
+    int ownerOf(uint64_t key) const { return int((key >> 40) % uint64_t(threadCount)); }
+
+    // Stores `state` in its owner unless the owner already has it at no greater g. Returns
+    // whether it was added to the open list.
+    bool addNode(Worker& worker, const State& state, const uint16_t* boxes) {
+        bool found = false;
+        TranspositionEntry* entry = worker.space.table.probe(state.boxHash ^ worker.space.keys.player(state.player), found);
+        if (found) {
+            if (entry->g <= state.g) {
+                worker.stats.duplicates++;
+                return false;
+            }
+            worker.nodes[entry->value].stale = true;
+        }
+        uint32_t index = uint32_t(worker.nodes.size());
+        worker.nodes.push_back({ state, false });
+        worker.boxPool.insert(worker.boxPool.end(), boxes, boxes + n);
+        entry->value = index;
+        entry->g = state.g;
+        uint64_t f = uint64_t(state.g + state.h);
+        worker.open.push((f << 48) | (uint64_t(0xffff - state.g) << 32) | index);
+        return true;
+    }
+
+    void flush(Worker& worker, int to) {
+        std::unique_ptr<StateBatch>& batch = worker.outbox[to];
+        if (batch && !batch->states.empty()) {
+            workers[to]->inbox.send(batch.release());
+        }
+    }
+
+    void recordSolution(int g, Location at) {
+        std::lock_guard<std::mutex> guard(solutionLock);
+        if (g < incumbent.load()) {
+            solution = at;
+            incumbent.store(g);
+        }
+    }
+
+    void stopAll(Worker& worker, SolverLimit limit) {
+        worker.stats.limit = limit;
+        stop.store(true);
+    }
+
+    // The main loop of thread `t`. `outstanding` counts the nodes in open lists plus the states
+    // in flight to their owners; a thread adds its children before it retires the parent and
+    // sends them only after that, so the count reaches zero only when the search is finished.
+    void work(int t) {
+        Worker& worker = *workers[t];
+        SearchSpace& space = worker.space;
+        std::vector<uint16_t> current(n);
+        std::vector<uint16_t> child(n);
+        int64_t retired = 0;  // nodes popped or dropped but not yet subtracted from `outstanding`
+        uint64_t sinceCheck = 0;
+        while (!stop.load(std::memory_order_relaxed)) {
+            int bound = incumbent.load(std::memory_order_acquire);
+            while (StateBatch* batch = worker.inbox.receive()) {
+                for (size_t i = 0; i < batch->states.size(); i++) {
+                    const State& state = batch->states[i];
+                    if (state.g + state.h >= bound || !addNode(worker, state, batch->boxes.data() + i * n)) {
+                        retired++;
+                    }
+                }
+                delete batch;
+            }
+
+            if (!worker.open.empty() && int(worker.open.top() >> 48) >= bound) {
+                retired += int64_t(worker.open.size());
+                worker.open = decltype(worker.open)();
+            }
+            if (worker.open.empty()) {
+                for (int to = 0; to < threadCount; to++) {
+                    flush(worker, to);
+                }
+                if (retired > 0) {
+                    outstanding.fetch_sub(retired);
+                    retired = 0;
+                }
+                if (outstanding.load() == 0) {
+                    break;
+                }
+                std::this_thread::yield();
+                continue;
+            }
+
+            uint32_t index = uint32_t(worker.open.top() & 0xffffffff);
+            worker.open.pop();
+            retired++;
+            if (worker.nodes[index].stale) {
+                continue;
+            }
+            if (++sinceCheck == 64) {
+                sinceCheck = 0;
+                uint64_t total = expandedTotal.fetch_add(64) + 64;
+                worker.stats.memoryBytes = std::max(worker.stats.memoryBytes, memoryBytes(worker));
+                if (total >= options.maxNodes) {
+                    stopAll(worker, LIMIT_NODES);
+                } else if (options.timeLimit > 0 &&
+                           std::chrono::duration<double>(Clock::now() - started).count() > options.timeLimit) {
+                    stopAll(worker, LIMIT_TIME);
+                } else if (options.memoryLimit > 0 && worker.stats.memoryBytes > options.memoryLimit / threadCount) {
+                    stopAll(worker, LIMIT_MEMORY);
+                }
+            }
+            worker.stats.expanded++;
+
+            State node = worker.nodes[index].state;
+            std::copy(worker.boxPool.begin() + size_t(index) * n, worker.boxPool.begin() + size_t(index + 1) * n,
+                      current.begin());
+            space.prepareChildren(current.data());
+            space.placeBoxes(current.data(), true);
+            space.reach(node.player);
+            int64_t added = 0;
+            for (int k = 0; k < n; k++) {
+                int from = current[k];
+                for (int d = 0; d < DIRECTION_COUNT; d++) {
+                    int to = from + space.offsets[d];
+                    if (!space.canPush(from, d) || space.work.isDeadAt(to)) {
+                        continue;
+                    }
+                    worker.stats.generated++;
+                    space.work.setBoxAt(from, false);
+                    space.work.setBoxAt(to, true);
+                    bool deadlocked = space.deadlocked(to, from);
+                    int childPlayer = deadlocked ? 0 : space.normalize(from);
+                    space.work.setBoxAt(to, false);
+                    space.work.setBoxAt(from, true);
+                    if (deadlocked) {
+                        worker.stats.deadlocks++;
+                        continue;
+                    }
+                    std::copy(current.begin(), current.end(), child.begin());
+                    moveBox(child.data(), n, k, to);
+                    int childH = space.childHeuristic(child.data(), k, to);
+                    if (childH == NO_SOLUTION || node.g + 1 + childH >= bound) {
+                        continue;
+                    }
+                    State state = { space.keys.push(node.boxHash, from, to), index, uint16_t(t), uint16_t(childPlayer),
+                                    uint16_t(from), uint16_t(node.g + 1), uint16_t(childH), uint8_t(d) };
+                    if (childH == 0) {
+                        // Kept out of the open lists; only its parent chain is needed.
+                        uint32_t goal = uint32_t(worker.nodes.size());
+                        worker.nodes.push_back({ state, true });
+                        worker.boxPool.insert(worker.boxPool.end(), child.begin(), child.end());
+                        recordSolution(state.g, { uint16_t(t), goal });
+                        bound = incumbent.load();
+                        continue;
+                    }
+                    int owner = ownerOf(state.boxHash ^ space.keys.player(childPlayer));
+                    if (owner == t) {
+                        added += addNode(worker, state, child.data());
+                        continue;
+                    }
+                    std::unique_ptr<StateBatch>& batch = worker.outbox[owner];
+                    if (!batch) {
+                        batch.reset(new StateBatch());
+                    }
+                    batch->states.push_back(state);
+                    batch->boxes.insert(batch->boxes.end(), child.begin(), child.end());
+                    added++;
+                }
+            }
+            space.placeBoxes(current.data(), false);
+
+            if (added != retired) {
+                outstanding.fetch_add(added - retired);
+            }
+            retired = 0;
+            // Full batches go at once, the rest every 64 expansions so no owner waits long.
+            for (int to = 0; to < threadCount; to++) {
+                if (worker.outbox[to] && (sinceCheck == 0 || worker.outbox[to]->states.size() >= BATCH_STATES)) {
+                    flush(worker, to);
+                }
+            }
+        }
+    }
+
+    size_t memoryBytes(const Worker& worker) const {
+        return worker.space.table.memoryBytes() + worker.nodes.capacity() * sizeof(Node) +
+               worker.boxPool.capacity() * sizeof(uint16_t) + worker.open.size() * sizeof(uint64_t);
+    }
+
+    const SolverOptions& options;
+    SolverStats& stats;
+    int threadCount;
+    int n;
+    std::vector<std::unique_ptr<Worker>> workers;
+    Clock::time_point started;
+    std::atomic<int> incumbent;  // pushes of the best solution so far
+    std::atomic<int64_t> outstanding;
+    std::atomic<uint64_t> expandedTotal;
+    std::atomic<bool> stop;
+    std::mutex solutionLock;
+    Location solution = { 0, NO_PARENT };
+};
+
+
+// Searches from both ends: first breadth-first over pulls from the solved positions with up to
+// half of the node budget (see PullSearch), then A* over pushes from the start until it pops a
+// pulled state. Inside the perimeter A* knows exact distances and outside it gets a tighter
+// bound, so the result stays push-optimal. With more goals than boxes the solved positions
+// are too many to start from and plain A* runs; with fewer goals than boxes there is nothing
+// to search and the limit is LIMIT_UNSUPPORTED.
+class BidirectionalSearch {
+public:
+    BidirectionalSearch(SearchSpace& space, const SolverOptions& options, SolverStats& stats)
+        : space(space), options(options), stats(stats), perimeter(space, options, stats) {}
+
+    bool run(std::vector<Push>& pushes) {
+        Clock::time_point started = Clock::now();
+        int n = space.boxCount;
+        if (int(space.goals.size()) < n) {
+            stats.limit = LIMIT_UNSUPPORTED;
+            return false;
+        }
+        if (int(space.goals.size()) > n) {
+            AStarSearch search(space, options, stats);
+            return search.run(pushes);
+        }
+        space.placeBoxes(space.startBoxes.data(), true);
+        int player = space.reach(space.startPlayer);
+        space.placeBoxes(space.startBoxes.data(), false);
+        uint64_t startKey = space.keys.boxes(space.startBoxes.data(), n) ^ space.keys.player(player);
+        if (!perimeter.grow(options.maxNodes / 2, startKey, started)) {
+            return false;
+        }
+        // A* keeps its own clock, so it gets what is left of the time limit.
+        SolverOptions rest = options;
+        if (rest.timeLimit > 0) {
+            rest.timeLimit = std::max(1e-9, rest.timeLimit - std::chrono::duration<double>(Clock::now() - started).count());
+        }
+        AStarSearch search(space, rest, stats, &perimeter);
+        return search.run(pushes);
+    }
+
+private:
+    SearchSpace& space;
+    const SolverOptions& options;
+    SolverStats& stats;
+    PullSearch perimeter;
+};
+
+
+// Keeps a solution found by any search if the game rules accept its moves.
+void acceptSolution(const Board& board, SearchSpace& space, const std::vector<Push>& pushes, SolverResult& result) {
+    std::string moves = solutionMoves(space, pushes);
+    if (verifySolution(board, moves)) {
+        result.solved = true;
+        result.moves = moves;
+        result.pushes = int(pushes.size());
+    } else {
+        std::cerr << "Solver produced a move sequence the game rules reject." << std::endl;
+    }
+}
+
+}  // namespace
+
+
+SolverResult solveLevel(const Board& board, const SolverOptions& options) {
+    Clock::time_point started = Clock::now();
+    SolverResult result;
+    // Under a memory limit the table takes at most half of it; the rest is left for nodes.
+    size_t tableBytes = options.tableBytes;
+    if (options.memoryLimit > 0) {
+        tableBytes = std::min(tableBytes, options.memoryLimit / 2);
+    }
+    std::shared_ptr<const PushDistanceTable> distances = options.pushDistances;
+    if (!distances && options.heuristic == HEURISTIC_PUSHES) {
+        distances = std::make_shared<const PushDistanceTable>(board);
+    }
+
+    std::vector<Push> pushes;
+    if (options.algorithm == SOLVER_HDASTAR) {
+        // Every thread gets its own space with an equal share of the table budget.
+        HdaStarSearch search(board, options, result.stats, tableBytes, distances.get());
+        if (search.run(pushes)) {
+            acceptSolution(board, search.space(), pushes, result);
+        }
+    } else {
+        SearchSpace space(board, tableBytes, options.heuristic, distances.get());
+        bool found = false;
+        if (options.algorithm == SOLVER_IDASTAR) {
+            IdaStarSearch search(space, options, result.stats);
+            found = search.run(pushes);
+        } else if (options.algorithm == SOLVER_BIDIRECTIONAL) {
+            BidirectionalSearch search(space, options, result.stats);
+            found = search.run(pushes);
+        } else {
+            AStarSearch search(space, options, result.stats);
+            found = search.run(pushes);
+        }
+        if (found) {
+            acceptSolution(board, space, pushes, result);
+        }
+        result.stats.table = space.table.stats();
+    }
+
+    result.stats.milliseconds = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+    return result;
+}
@@ -0,0 +1,75 @@
+#ifndef SOKOBAN_SOLVER_H
+#define SOKOBAN_SOLVER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "board.h"
+#include "heuristic.h"
+#include "transposition.h"
+
+
+// SOLVER_HDASTAR is A* spread over SolverOptions::threads threads (hash-distributed A*).
+// SOLVER_BIDIRECTIONAL searches pushes from the start and pulls from the solved positions.
+enum SolverAlgorithm { SOLVER_ASTAR, SOLVER_IDASTAR, SOLVER_HDASTAR, SOLVER_BIDIRECTIONAL };
+
+
+// Why a search ended without a solution. LIMIT_UNSUPPORTED: the algorithm cannot search the
+// level at all (SOLVER_BIDIRECTIONAL with fewer goals than boxes).
+enum SolverLimit { LIMIT_NONE, LIMIT_NODES, LIMIT_TIME, LIMIT_MEMORY, LIMIT_UNSUPPORTED };
+
+
+struct SolverOptions {
+    SolverAlgorithm algorithm = SOLVER_ASTAR;
+    uint64_t maxNodes = 2000000;  // expanded nodes before giving up
+    double timeLimit = 0.0;       // seconds, 0 for no limit
+    size_t tableBytes = size_t(64) << 20;  // transposition table budget; A* and HDA* grow past it
+    HeuristicKind heuristic = HEURISTIC_PUSHES;
+    // SOLVER_ASTAR only: fill the goals in a planned order and take a box that reaches them
+    // straight to the next goal, cutting every other push. Much faster on levels with a goal
+    // room, but the solution is no longer guaranteed to use the fewest pushes.
+    bool goalMacros = false;
+    // The level's push distances, if already built; solveLevel() builds them otherwise.
+    std::shared_ptr<const PushDistanceTable> pushDistances;
+    int threads = 1;              // SOLVER_HDASTAR only
+    size_t memoryLimit = 0;  // bytes for the table plus the open and closed nodes, 0 for no limit
+};
+
+
+// Where a bidirectional search met, and how many states each side stored.
+struct MeetingStats {
+    uint64_t forwardStates = 0;
+    uint64_t backwardStates = 0;
+    uint64_t meetings = 0;  // pushed states found among the pulled ones
+    int forwardDepth = 0;   // pushes from the start to the meeting state of the solution
+    int backwardDepth = 0;  // pulls from a solved position back to it
+};
+
+
+struct SolverStats {
+    uint64_t expanded = 0;
+    uint64_t generated = 0;
+    uint64_t duplicates = 0;
+    uint64_t deadlocks = 0;  // pushes dropped by the freeze deadlock check
+    double milliseconds = 0.0;
+    size_t memoryBytes = 0;  // peak search memory, as counted against memoryLimit
+    SolverLimit limit = LIMIT_NONE;  // set if a limit stopped the search; LIMIT_NONE otherwise
+    TranspositionStats table;
+    MeetingStats meeting;  // SOLVER_BIDIRECTIONAL only
+};
+
+
+struct SolverResult {
+    bool solved = false;
+    std::string moves;  // LURD notation, uppercase letters are pushes
+    int pushes = 0;
+    SolverStats stats;
+};
+
+
+// Searches for a push-optimal solution of `board`. Needs no SDL initialization.
+// Pushes onto cells marked CELL_DEAD (see markDeadSquares) are never generated, and pushes
+// that freeze a box off goal (see isFreezeDeadlock) are dropped.
+SolverResult solveLevel(const Board& board, const SolverOptions& options = SolverOptions());
+
+#endif
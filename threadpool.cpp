@@ -0,0 +1,92 @@
+#include "threadpool.h"
+#include <algorithm>
+
+WorkStealingPool::WorkStealingPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+    for (int i = 0; i < threadCount; i++) {
+        workers.push_back(std::unique_ptr<Worker>(new Worker()));
+    }
+    for (int i = 0; i < threadCount; i++) {
+        threads.emplace_back(&WorkStealingPool::workerLoop, this, i);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::submit(std::function<void()> task) {
+    Worker& worker = *workers[nextWorker++ % workers.size()];
+    {
+        std::lock_guard<std::mutex> guard(worker.lock);
+        worker.tasks.push_back(std::move(task));
+    }
+    {
+        std::lock_guard<std::mutex> guard(stateLock);
+        queued++;
+        unfinished++;
+    }
+    wake.notify_one();
+}
+
+void WorkStealingPool::wait() {
+    std::unique_lock<std::mutex> guard(stateLock);
+    finished.wait(guard, [this]() { return unfinished == 0; });
+}
+
+bool WorkStealingPool::takeTask(int self, std::function<void()>& task) {
+    int count = int(workers.size());
+    for (int i = 0; i < count; i++) {
+        Worker& worker = *workers[(self + i) % count];
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if (worker.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+        } else {
+            task = std::move(worker.tasks.front());
+            worker.tasks.pop_front();
+            stealCount++;
+        }
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::workerLoop(int self) {
+    std::function<void()> task;
+    while (true) {
+        if (takeTask(self, task)) {
+            {
+                std::lock_guard<std::mutex> guard(stateLock);
+                queued--;
+            }
+            task();
+            task = nullptr;
+            std::lock_guard<std::mutex> guard(stateLock);
+            if (--unfinished == 0) {
+                finished.notify_all();
+            }
+            continue;
+        }
+        // `queued` can stay above zero for a moment after another worker took the last task,
+        // in which case this simply looks again.
+        std::unique_lock<std::mutex> guard(stateLock);
+        wake.wait(guard, [this]() { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef SOKOBAN_THREADPOOL_H
+#define SOKOBAN_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// Fixed set of worker threads, each with its own task deque. Submitted tasks are dealt to the
+// deques in turn; a worker runs its own tasks newest first and, once its deque is empty, steals
+// the oldest task of another worker. Tasks of very uneven length (solving one level each) keep
+// every thread busy until the last ones finish.
+class WorkStealingPool {
+public:
+    // 0 threads means one per hardware thread.
+    explicit WorkStealingPool(int threads = 0);
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished.
+    void wait();
+
+    int threadCount() const { return int(threads.size()); }
+    uint64_t steals() const { return stealCount.load(); }
+
+private:
+    struct Worker {
+        std::mutex lock;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    bool takeTask(int self, std::function<void()>& task);
+    void workerLoop(int self);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+    std::mutex stateLock;
+    std::condition_variable wake;      // a task was queued, or the pool is stopping
+    std::condition_variable finished;  // the last unfinished task completed
+    size_t queued = 0;      // submitted, not yet taken by a worker
+    size_t unfinished = 0;  // submitted, not yet completed
+    size_t nextWorker = 0;
+    bool stopping = false;
+    std::atomic<uint64_t> stealCount{ 0 };
+};
+
+#endif
@@ -0,0 +1,100 @@
+#include "transposition.h"
+
+namespace {
+
+uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+}  // namespace
+
+
+ZobristKeys::ZobristKeys(int cellCount, uint64_t seed)
+    : boxKeys(cellCount), playerKeys(cellCount) {
+    uint64_t state = seed;
+    for (int i = 0; i < cellCount; i++) {
+        boxKeys[i] = splitMix64(state);
+        playerKeys[i] = splitMix64(state);
+    }
+}
+
+uint64_t ZobristKeys::boxes(const uint16_t* cells, int count) const {
+    uint64_t hash = 0;
+    for (int k = 0; k < count; k++) {
+        hash ^= boxKeys[cells[k]];
+    }
+    return hash;
+}
+
+
+TranspositionTable::TranspositionTable(size_t memoryBytes)
+    : used(0), currentGeneration(0), exact(false) {
+    size_t capacity = 1024;
+    while (capacity * 2 * sizeof(TranspositionEntry) <= memoryBytes) {
+        capacity *= 2;
+    }
+    entries.assign(capacity, TranspositionEntry{ 0, 0, 0, 0 });
+    mask = capacity - 1;
+}
+
+TranspositionEntry* TranspositionTable::probe(uint64_t key, bool& found) {
+    if (key == 0) {
+        key = 1;
+    }
+    counters.probes++;
+    if (exact && 2 * (used + 1) > entries.size()) {
+        grow();
+    }
+    // An exact table is at most half full, so its run always ends at an empty slot.
+    int limit = exact ? int(entries.size()) : PROBE_LIMIT;
+    TranspositionEntry* victim = nullptr;
+    size_t slot = size_t(key) & mask;
+    for (int i = 0; i < limit; i++, slot = (slot + 1) & mask) {
+        TranspositionEntry& entry = entries[slot];
+        if (entry.key == key) {
+            counters.hits++;
+            found = true;
+            return &entry;
+        }
+        if (entry.key == 0) {
+            victim = &entry;
+            break;
+        }
+        counters.collisions++;
+        if (!victim || (victim->generation == currentGeneration &&
+                        (entry.generation != currentGeneration || entry.g > victim->g))) {
+            victim = &entry;
+        }
+    }
+
+    if (victim->key != 0) {
+        counters.evictions++;
+    } else {
+        used++;
+    }
+    counters.stores++;
+    found = false;
+    victim->key = key;
+    victim->generation = currentGeneration;
+    return victim;
+}
+
+void TranspositionTable::grow() {
+    std::vector<TranspositionEntry> old(entries.size() * 2, TranspositionEntry{ 0, 0, 0, 0 });
+    old.swap(entries);
+    mask = entries.size() - 1;
+    for (const TranspositionEntry& entry : old) {
+        if (entry.key == 0) {
+            continue;
+        }
+        size_t slot = size_t(entry.key) & mask;
+        while (entries[slot].key != 0) {
+            slot = (slot + 1) & mask;
+        }
+        entries[slot] = entry;
+    }
+    counters.resizes++;
+}
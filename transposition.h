@@ -0,0 +1,80 @@
+#ifndef SOKOBAN_TRANSPOSITION_H
+#define SOKOBAN_TRANSPOSITION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+
+// Random 64-bit keys per cell. A state hash is the XOR of the keys of all box cells
+// and the key of the canonical player cell, so a push updates it with two XORs.
+class ZobristKeys {
+public:
+    explicit ZobristKeys(int cellCount, uint64_t seed = 0x9e3779b97f4a7c15ULL);
+
+    uint64_t box(int cell) const { return boxKeys[cell]; }
+    uint64_t player(int cell) const { return playerKeys[cell]; }
+    uint64_t boxes(const uint16_t* cells, int count) const;
+    uint64_t push(uint64_t boxHash, int from, int to) const { return boxHash ^ boxKeys[from] ^ boxKeys[to]; }
+
+private:
+    std::vector<uint64_t> boxKeys;
+    std::vector<uint64_t> playerKeys;
+};
+
+
+struct TranspositionStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0;
+    uint64_t stores = 0;
+    uint64_t collisions = 0;  // a probed slot held a different state
+    uint64_t evictions = 0;   // a live entry was replaced to make room
+    uint64_t resizes = 0;     // an exact table doubled its size
+};
+
+
+struct TranspositionEntry {
+    uint64_t key;  // 0 marks an empty slot
+    uint32_t value;
+    uint16_t g;
+    uint16_t generation;
+};
+
+
+// Open-addressed table of visited states. Each key probes a short run of slots; when the
+// run is full the entry from an older generation, or else the deepest one, is replaced.
+// An exact table probes until it finds the key or an empty slot and doubles in size when half
+// full, so it never replaces an entry and can serve as a closed set. Keys are full 64-bit hashes and are trusted
+// without verification.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t memoryBytes);
+
+    // `memoryBytes` is then only the starting size.
+    void setExact(bool on) { exact = on; }
+
+    // Returns the entry holding `key` and sets `found`, or returns the slot the caller
+    // should fill for it (with its key already written) and clears `found`.
+    TranspositionEntry* probe(uint64_t key, bool& found);
+
+    void newGeneration() { currentGeneration++; }
+    uint16_t generation() const { return currentGeneration; }
+    size_t capacity() const { return entries.size(); }
+    size_t memoryBytes() const { return entries.size() * sizeof(TranspositionEntry); }
+    const TranspositionStats& stats() const { return counters; }
+
+private:
+    static const int PROBE_LIMIT = 4;
+
+    // Doubles the table and reinserts every entry.
+    void grow();
+
+    std::vector<TranspositionEntry> entries;
+    size_t mask;
+    size_t used;  // slots with a key
+    uint16_t currentGeneration;
+    bool exact;
+    TranspositionStats counters;
+};
+
+#endif
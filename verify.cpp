@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "binarypack.h"
+#include "levelpack.h"
+#include "levels.h"
+#include "replay.h"
+
+// Headless replay verifier, no SDL involved:
+//   sokoban-replay [--pack FILE] [--quiet] [--repeat N] REPLAYS...
+// Checks every replay in the given files against the rules in Board::movePlayer() and the
+// level it was recorded on. Exits with 2 if any replay is invalid.
+int main(int argc, char* argv[]) {
+    std::string packPath;
+    bool quiet = false;
+    int repeat = 1;
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--pack") == 0 && i + 1 < argc) {
+            packPath = argv[++i];
+        } else if (std::strcmp(argv[i], "--quiet") == 0) {
+            quiet = true;
+        } else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc) {
+            repeat = std::max(1, std::atoi(argv[++i]));
+        } else if (argv[i][0] == '-') {
+            std::cerr << "Unknown argument: " << argv[i] << std::endl;
+            return 1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [--pack FILE] [--quiet] [--repeat N] REPLAYS..." << std::endl;
+        return 1;
+    }
+
+    std::vector<Board> levels;
+    if (packPath.empty()) {
+        levels = loadBuiltinLevels();
+    } else if (BinaryLevelPack::isBinaryPackPath(packPath)) {
+        if (!loadBinaryPack(packPath, levels)) {
+            return 1;
+        }
+    } else if (!loadLevelPack(packPath, levels)) {
+        return 1;
+    }
+
+    struct Entry {
+        std::string where;
+        Replay replay;
+    };
+    std::vector<Entry> entries;
+    int malformed = 0;
+    for (const std::string& file : files) {
+        std::ifstream in(file);
+        if (!in) {
+            std::cerr << "Unable to open " << file << std::endl;
+            return 1;
+        }
+        std::string line;
+        int lineNumber = 0;
+        while (std::getline(in, line)) {
+            lineNumber++;
+            if (line.empty() || line[0] == '#') {
+                continue;
+            }
+            Entry entry;
+            entry.where = file + ":" + std::to_string(lineNumber);
+            std::string error;
+            if (!parseReplay(line, entry.replay, error)) {
+                std::cout << entry.where << ": malformed, " << error << std::endl;
+                malformed++;
+                continue;
+            }
+            entries.push_back(entry);
+        }
+    }
+
+    // Level hashes are computed once per level, not once per replay.
+    std::vector<uint64_t> hashes(levels.size(), 0);
+    std::vector<bool> hashed(levels.size(), false);
+    int valid = 0;
+    int solved = 0;
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < repeat; pass++) {
+        bool report = pass == 0;
+        for (const Entry& entry : entries) {
+            const Replay& replay = entry.replay;
+            ReplayCheck check;
+            if (replay.level >= int(levels.size())) {
+                check.error = "no level " + std::to_string(replay.level + 1);
+            } else {
+                if (!hashed[replay.level]) {
+                    hashes[replay.level] = levelHash(levels[replay.level]);
+                    hashed[replay.level] = true;
+                }
+                if (hashes[replay.level] != replay.levelHash) {
+                    check.error = "recorded on a different level " + std::to_string(replay.level + 1);
+                } else {
+                    check = verifyReplay(levels[replay.level], replay);
+                }
+            }
+            if (!report) {
+                continue;
+            }
+            valid += check.valid;
+            solved += check.solved;
+            if (!check.valid) {
+                std::cout << entry.where << ": level " << replay.level + 1 << " INVALID, " << check.error << std::endl;
+            } else if (!quiet) {
+                std::cout << entry.where << ": level " << replay.level + 1 << (check.solved ? " solved, " : " not solved, ")
+                          << check.moves << " moves, " << check.pushes << " pushes, " << check.milliseconds << " ms" << std::endl;
+            }
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    double verified = double(entries.size()) * repeat;
+    std::cout << entries.size() << " replays: " << valid << " valid, " << solved << " solved, "
+              << int(entries.size()) - valid << " invalid, " << malformed << " malformed; " << verified << " checks in " << ms
+              << " ms (" << (ms > 0.0 ? verified * 1000.0 / ms : 0.0) << " replays/s)" << std::endl;
+    return valid == int(entries.size()) && malformed == 0 ? 0 : 2;
+}